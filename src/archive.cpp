@@ -0,0 +1,506 @@
+#include "archive.h"
+#include "manifest.h"
+#include "repository.h"
+#include "repostate.h"
+#include "zstd.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static const std::size_t CHUNK = 1 << 20;
+static const std::size_t TAR_BLOCK = 512;
+static const std::size_t TAR_RECORD = 20 * TAR_BLOCK;
+
+static void writeAll(const char *data, std::size_t len)
+{
+    while (len > 0)
+    {
+#ifdef _WIN32
+        int n = _write(1, data, static_cast<unsigned>(std::min<std::size_t>(len, 1 << 30)));
+#else
+        ssize_t n = ::write(1, data, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+#endif
+        if (n <= 0)
+            throw std::runtime_error("write to stdout failed");
+        data += n;
+        len -= n;
+    }
+}
+
+// Where the tar stream goes: straight to stdout, or through the compressor.
+class Output
+{
+public:
+    virtual ~Output() = default;
+    virtual void write(const char *data, std::size_t len) = 0;
+    virtual void finish() {}
+
+    // Tar code goes through these, so the stream length is known.
+    void put(const char *data, std::size_t len)
+    {
+        written += len;
+        write(data, len);
+    }
+
+    void putFile(const fs::path &path, std::uintmax_t size)
+    {
+        written += size;
+        file(path, size);
+    }
+
+    std::uintmax_t written = 0;
+
+protected:
+    virtual void file(const fs::path &path, std::uintmax_t size)
+    {
+        std::ifstream in(path, std::ios::binary);
+        char buf[65536];
+
+        while (size > 0)
+        {
+            in.read(buf, std::min<std::uintmax_t>(size, sizeof(buf)));
+            if (in.gcount() <= 0)
+                break;
+
+            write(buf, in.gcount());
+            size -= in.gcount();
+        }
+
+        if (size > 0)
+            throw std::runtime_error(path.string() + ": file shrank while archiving");
+    }
+};
+
+class RawOutput : public Output
+{
+public:
+    void write(const char *data, std::size_t len) override
+    {
+        writeAll(data, len);
+    }
+
+protected:
+    // Kernel-side copy from the object file to stdout.
+    void file(const fs::path &path, std::uintmax_t size) override
+    {
+#ifdef __linux__
+        int in = open(path.c_str(), O_RDONLY);
+        if (in < 0)
+            throw std::runtime_error(path.string() + ": cannot open");
+
+        std::uintmax_t left = size;
+        while (left > 0)
+        {
+            ssize_t n = sendfile(1, in, nullptr, std::min<std::uintmax_t>(left, 1 << 30));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && left == size && (errno == EINVAL || errno == ENOSYS))
+                break; // stdout does not support sendfile; copy instead
+            if (n <= 0)
+            {
+                close(in);
+                throw std::runtime_error(path.string() + ": sendfile failed");
+            }
+            left -= n;
+        }
+        close(in);
+
+        if (left == 0)
+            return;
+#endif
+        Output::file(path, size);
+    }
+};
+
+/*
+ * Compression pipeline: the producer fills 1 MiB chunks, workers turn
+ * each into a zstd frame, the writer thread emits frames in submission
+ * order. submit() blocks while 2 chunks per worker are in flight.
+ */
+class ZstdOutput : public Output
+{
+public:
+    explicit ZstdOutput(unsigned threads) : limit_(2 * threads)
+    {
+        chunk_.reserve(CHUNK);
+        for (unsigned i = 0; i < threads; i++)
+            workers_.emplace_back([this]() { work(); });
+        writer_ = std::thread([this]() { emit(); });
+    }
+
+    ~ZstdOutput() override
+    {
+        stop();
+    }
+
+    void write(const char *data, std::size_t len) override
+    {
+        while (len > 0)
+        {
+            std::size_t take = std::min(len, CHUNK - chunk_.size());
+            chunk_.append(data, take);
+            data += take;
+            len -= take;
+
+            if (chunk_.size() == CHUNK)
+                submit();
+        }
+    }
+
+    void finish() override
+    {
+        if (!chunk_.empty())
+            submit();
+        stop();
+
+        if (failed_)
+            throw std::runtime_error("write to stdout failed");
+    }
+
+private:
+    void submit()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return submitted_ - written_ < limit_ || failed_; });
+        if (failed_)
+            throw std::runtime_error("write to stdout failed");
+
+        jobs_.emplace_back(submitted_++, std::move(chunk_));
+        chunk_ = std::string();
+        chunk_.reserve(CHUNK);
+        cv_.notify_all();
+    }
+
+    void work()
+    {
+        for (;;)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return !jobs_.empty() || closing_; });
+            if (jobs_.empty())
+                return;
+
+            auto job = std::move(jobs_.front());
+            jobs_.pop_front();
+            lock.unlock();
+
+            std::string frame = Zstd::compressFrame(job.second.data(), job.second.size());
+
+            lock.lock();
+            done_[job.first] = std::move(frame);
+            cv_.notify_all();
+        }
+    }
+
+    void emit()
+    {
+        for (;;)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return done_.count(written_) || (closing_ && written_ == submitted_); });
+            if (!done_.count(written_))
+                return;
+
+            std::string frame = std::move(done_[written_]);
+            done_.erase(written_);
+            bool ok = !failed_;
+            lock.unlock();
+
+            if (ok)
+            {
+                try
+                {
+                    writeAll(frame.data(), frame.size());
+                }
+                catch (const std::exception &)
+                {
+                    ok = false;
+                }
+            }
+
+            lock.lock();
+            failed_ = failed_ || !ok;
+            written_++;
+            cv_.notify_all();
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            closing_ = true;
+        }
+        cv_.notify_all();
+
+        for (auto &t : workers_)
+            if (t.joinable())
+                t.join();
+        if (writer_.joinable())
+            writer_.join();
+    }
+
+    std::size_t limit_;
+    std::string chunk_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::pair<std::size_t, std::string>> jobs_;
+    std::map<std::size_t, std::string> done_;
+    std::size_t submitted_ = 0, written_ = 0;
+    bool closing_ = false, failed_ = false;
+
+    std::vector<std::thread> workers_;
+    std::thread writer_;
+};
+
+// ---- tar ----
+
+// width - 1 zero-padded octal digits and a NUL. Formatted at full
+// 64-bit width first, so the buffer can never be too small.
+static void octal(char *field, std::size_t width, std::uintmax_t value)
+{
+    char digits[24];
+    int n = std::snprintf(digits, sizeof(digits), "%022llo", static_cast<unsigned long long>(value));
+    std::memcpy(field, digits + n - (width - 1), width - 1);
+    field[width - 1] = '\0';
+}
+
+static void checksum(char *header)
+{
+    std::memset(header + 148, ' ', 8);
+
+    unsigned sum = 0;
+    for (std::size_t i = 0; i < TAR_BLOCK; i++)
+        sum += static_cast<unsigned char>(header[i]);
+
+    std::snprintf(header + 148, 8, "%06o", sum);
+    header[155] = ' ';
+}
+
+static void pad(Output &out, std::uintmax_t written)
+{
+    static const char zeros[TAR_BLOCK] = {};
+    std::size_t rest = written % TAR_BLOCK;
+    if (rest)
+        out.put(zeros, TAR_BLOCK - rest);
+}
+
+// Splits a path into ustar prefix/name; false if it does not fit.
+static bool splitPath(const std::string &path, std::string &prefix, std::string &name)
+{
+    if (path.size() <= 100)
+    {
+        prefix.clear();
+        name = path;
+        return true;
+    }
+
+    for (std::size_t slash = path.find('/'); slash != std::string::npos; slash = path.find('/', slash + 1))
+    {
+        if (slash <= 155 && path.size() - slash - 1 <= 100 && slash + 1 < path.size())
+        {
+            prefix = path.substr(0, slash);
+            name = path.substr(slash + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void header(Output &out, const std::string &name, const std::string &prefix, char type,
+                   unsigned mode, std::uintmax_t size, std::uintmax_t mtime)
+{
+    char h[TAR_BLOCK] = {};
+
+    std::memcpy(h, name.data(), std::min<std::size_t>(name.size(), 100));
+    octal(h + 100, 8, mode);
+    octal(h + 108, 8, 0);
+    octal(h + 116, 8, 0);
+    octal(h + 124, 12, size);
+    octal(h + 136, 12, mtime);
+    h[156] = type;
+    std::memcpy(h + 257, "ustar", 6);
+    std::memcpy(h + 263, "00", 2);
+    std::memcpy(h + 345, prefix.data(), std::min<std::size_t>(prefix.size(), 155));
+    checksum(h);
+
+    out.put(h, TAR_BLOCK);
+}
+
+// "<len> key=value\n", where <len> counts the whole record.
+static std::string paxRecord(const std::string &key, const std::string &value)
+{
+    std::size_t body = key.size() + value.size() + 3;
+    std::size_t len = body + std::to_string(body).size();
+    if (std::to_string(len).size() != std::to_string(body).size())
+        len++;
+    return std::to_string(len) + " " + key + "=" + value + "\n";
+}
+
+static void entry(Output &out, const std::string &path, const fs::path &file,
+                  std::uintmax_t size, unsigned mode, std::uintmax_t mtime)
+{
+    const std::uintmax_t MAX_OCTAL_SIZE = 077777777777ULL;
+    std::string prefix, name;
+    std::string pax;
+
+    if (!splitPath(path, prefix, name))
+    {
+        pax += paxRecord("path", path);
+        name = path.substr(0, 100);
+        prefix.clear();
+    }
+    if (size > MAX_OCTAL_SIZE)
+        pax += paxRecord("size", std::to_string(size));
+
+    if (!pax.empty())
+    {
+        header(out, "PaxHeader", "", 'x', 0644, pax.size(), mtime);
+        out.put(pax.data(), pax.size());
+        pad(out, pax.size());
+    }
+
+    header(out, name, prefix, '0', mode, std::min(size, MAX_OCTAL_SIZE), mtime);
+    out.putFile(file, size);
+    pad(out, size);
+}
+
+// ---- command ----
+
+static std::string resolve(const std::string &rev)
+{
+    if (!rev.empty() && fs::is_directory(Repository::objectDir(rev)))
+        return rev;
+
+    if (fs::is_regular_file(".mygit/branches/" + rev))
+    {
+        std::string commit = RepoState::firstLine(".mygit/branches/" + rev);
+        if (!commit.empty() && commit != "NONE")
+            return commit;
+    }
+
+    return "";
+}
+
+// Commit IDs start with the commit's Unix time.
+static std::uintmax_t commitTime(const std::string &commit)
+{
+    std::uintmax_t t = 0;
+    for (char c : commit)
+    {
+        if (c < '0' || c > '9')
+            break;
+        t = t * 10 + (c - '0');
+    }
+    return t;
+}
+
+/*
+ * @brief Write a commit's snapshot to stdout as a tar stream.
+ *
+ * @param rev Commit ID or branch name.
+ * @param format "tar" or "tar.zst".
+ * @param threads Compression workers for tar.zst; 0 = one per core.
+ * @return Exit status.
+ */
+int Archive::run(const std::string &rev, const std::string &format, unsigned threads)
+{
+    if (!Repository::exists())
+    {
+        std::cout << "Not a mygit repository.\n";
+        return 1;
+    }
+
+    if (format != "tar" && format != "tar.zst")
+    {
+        std::cerr << "Unknown archive format: " << format << " (use tar or tar.zst)\n";
+        return 1;
+    }
+
+    std::string commit = resolve(rev);
+    if (commit.empty())
+    {
+        std::cerr << "No such commit or branch: " << rev << "\n";
+        return 1;
+    }
+
+#ifdef _WIN32
+    _setmode(_fileno(stdout), _O_BINARY);
+    bool terminal = _isatty(_fileno(stdout));
+#else
+    bool terminal = isatty(STDOUT_FILENO);
+#endif
+    if (terminal)
+    {
+        std::cerr << "Refusing to write an archive to a terminal; redirect stdout.\n";
+        return 1;
+    }
+
+    std::cout.flush();
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    fs::path filesPath = Repository::objectDir(commit) + "/files";
+    std::uintmax_t mtime = commitTime(commit);
+
+    try
+    {
+        std::unique_ptr<Output> out;
+        if (format == "tar")
+            out = std::make_unique<RawOutput>();
+        else
+            out = std::make_unique<ZstdOutput>(threads);
+
+        for (auto &[path, e] : Manifest::load(commit))
+        {
+            fs::path file = filesPath / path;
+            std::uintmax_t size = fs::file_size(file);
+            bool exec = (fs::status(file).permissions() & fs::perms::owner_exec) != fs::perms::none;
+
+            entry(*out, path, file, size, exec ? 0755 : 0644, mtime);
+        }
+
+        // End of archive: two zero blocks, padded to a whole tar record.
+        std::vector<char> zeros(TAR_RECORD);
+        std::uintmax_t end = out->written + 2 * TAR_BLOCK;
+        out->put(zeros.data(), 2 * TAR_BLOCK + (TAR_RECORD - end % TAR_RECORD) % TAR_RECORD);
+        out->finish();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "archive: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
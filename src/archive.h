@@ -0,0 +1,24 @@
+/*
+Archive = stream one commit's snapshot to stdout, no checkout needed.
+    mygit archive <commit|branch> [--format=tar|tar.zst] [--threads=<n>]
+tar     : ustar headers (pax records for long paths / huge files);
+          file bodies go from the object store to stdout with
+          sendfile, never through a user-space buffer.
+tar.zst : the same tar stream cut into 1 MiB chunks; worker threads
+          compress each chunk into its own zstd frame and a writer
+          emits the frames in order. At most 2 chunks per worker are
+          in flight, so memory stays constant whatever the snapshot size.
+The working tree and index are never touched.
+*/
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <string>
+
+class Archive
+{
+public:
+    static int run(const std::string &rev, const std::string &format, unsigned threads);
+};
+
+#endif
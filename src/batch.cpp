@@ -0,0 +1,243 @@
+#include "batch.h"
+#include "command.h"
+#include <exception>
+#include <iostream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+static const char END_OF_RESPONSE[] = {'\0', '\n'};
+
+/*
+ * @brief Split a request line into argv.
+ *
+ * Words are separated by whitespace; "..." and '...' group words,
+ * and a backslash escapes the next character outside single quotes.
+ *
+ * @param line The request, without the leading "mygit".
+ * @return argv with "mygit" as argv[0].
+ */
+std::vector<std::string> Batch::parseLine(const std::string &line)
+{
+    std::vector<std::string> args{"mygit"};
+    std::string word;
+    bool inWord = false;
+    char quote = 0;
+
+    for (std::size_t i = 0; i < line.size(); i++)
+    {
+        char c = line[i];
+
+        if (quote)
+        {
+            if (c == quote)
+                quote = 0;
+            else if (c == '\\' && quote == '"' && i + 1 < line.size())
+                word += line[++i];
+            else
+                word += c;
+        }
+        else if (c == '"' || c == '\'')
+        {
+            quote = c;
+            inWord = true;
+        }
+        else if (c == '\\' && i + 1 < line.size())
+        {
+            word += line[++i];
+            inWord = true;
+        }
+        else if (c == ' ' || c == '\t' || c == '\r')
+        {
+            if (inWord)
+                args.push_back(word);
+            word.clear();
+            inWord = false;
+        }
+        else
+        {
+            word += c;
+            inWord = true;
+        }
+    }
+
+    if (inWord)
+        args.push_back(word);
+
+    return args;
+}
+
+// Runs one request; a failing command must not take the session down.
+static void execute(const std::vector<std::string> &args)
+{
+    // Binary output would break the response framing.
+    if (args.size() >= 2 && args[1] == "archive")
+    {
+        std::cout << "error: archive is not available in batch/server mode\n";
+        return;
+    }
+
+    // Benchmarks write thousands of scratch files and would stall the session.
+    if (args.size() >= 2 && args[1] == "materialize")
+    {
+        std::cout << "error: materialize is not available in batch/server mode\n";
+        return;
+    }
+
+    try
+    {
+        Command::run(args);
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << "error: " << e.what() << "\n";
+    }
+}
+
+int Batch::run()
+{
+    std::string line;
+
+    while (std::getline(std::cin, line))
+    {
+        auto args = parseLine(line);
+        if (args.size() < 2)
+            continue;
+        if (args[1] == "quit" || args[1] == "shutdown")
+            break;
+
+        execute(args);
+        std::cout.write(END_OF_RESPONSE, sizeof(END_OF_RESPONSE));
+        std::cout.flush();
+    }
+
+    return 0;
+}
+
+#ifndef _WIN32
+static bool sendAll(int fd, const std::string &data)
+{
+    std::size_t sent = 0;
+    while (sent < data.size())
+    {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    return true;
+}
+
+/*
+ * @brief Serve one client connection.
+ *
+ * Output of each command is captured by swapping std::cout's buffer,
+ * so every module keeps printing to std::cout as usual.
+ *
+ * @return false if the client asked the server to shut down.
+ */
+static bool serveClient(int client)
+{
+    std::string pending;
+    char buf[4096];
+
+    while (true)
+    {
+        std::size_t nl;
+        while ((nl = pending.find('\n')) != std::string::npos)
+        {
+            auto args = Batch::parseLine(pending.substr(0, nl));
+            pending.erase(0, nl + 1);
+
+            if (args.size() < 2)
+                continue;
+            if (args[1] == "quit")
+                return true;
+            if (args[1] == "shutdown")
+                return false;
+
+            std::ostringstream out;
+            std::streambuf *saved = std::cout.rdbuf(out.rdbuf());
+            execute(args);
+            std::cout.rdbuf(saved);
+
+            std::string reply = out.str();
+            reply.append(END_OF_RESPONSE, sizeof(END_OF_RESPONSE));
+            if (!sendAll(client, reply))
+                return true;
+        }
+
+        ssize_t n = recv(client, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return true;
+        pending.append(buf, n);
+    }
+}
+#endif
+
+int Batch::serve(const std::string &socketPath)
+{
+#ifdef _WIN32
+    (void)socketPath;
+    std::cout << "Server mode needs Unix domain sockets; use --batch instead.\n";
+    return 1;
+#else
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+
+    if (socketPath.size() >= sizeof(addr.sun_path))
+    {
+        std::cout << "Socket path too long: " << socketPath << "\n";
+        return 1;
+    }
+    std::strcpy(addr.sun_path, socketPath.c_str());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        std::cout << "socket: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    unlink(socketPath.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || listen(fd, 16) < 0)
+    {
+        std::cout << "Cannot listen on " << socketPath << ": " << std::strerror(errno) << "\n";
+        close(fd);
+        return 1;
+    }
+
+    std::cout << "Listening on " << socketPath << "\n";
+    std::cout.flush();
+
+    // Commands share the working directory, so clients are served one at a time.
+    bool running = true;
+    while (running)
+    {
+        int client = accept(fd, nullptr, nullptr);
+        if (client < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        running = serveClient(client);
+        close(client);
+    }
+
+    close(fd);
+    unlink(socketPath.c_str());
+    return 0;
+#endif
+}
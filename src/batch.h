@@ -0,0 +1,27 @@
+/*
+Batch / server mode: one process, many commands.
+    mygit --batch          read commands from stdin
+    mygit --serve <socket> accept commands on a Unix domain socket
+Protocol (both modes):
+    request  = one line, the command as it would follow "mygit"
+               (double/single quotes group words: commit "two words")
+    response = the command's output, then a line holding a single NUL
+    "quit" ends the session, "shutdown" also stops the server.
+The object cache and repository state stay loaded between commands;
+HEAD, refs and the index are revalidated on every use.
+*/
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <string>
+#include <vector>
+
+class Batch
+{
+public:
+    static std::vector<std::string> parseLine(const std::string &line);
+    static int run();
+    static int serve(const std::string &socketPath);
+};
+
+#endif
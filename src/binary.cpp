@@ -0,0 +1,144 @@
+#include "binary.h"
+#include "repostate.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+static const std::size_t SNIFF_BYTES = 8000;
+
+// Glob match: '*' and '?' stay within a component, '**' crosses them.
+static bool glob(const char *p, const char *s)
+{
+    if (*p == '\0')
+        return *s == '\0';
+
+    if (p[0] == '*' && p[1] == '*')
+    {
+        p += 2;
+        if (*p == '\0')
+            return true;
+        if (*p == '/')
+            p++;
+
+        for (const char *t = s;; t++)
+        {
+            if ((t == s || t[-1] == '/') && glob(p, t))
+                return true;
+            if (*t == '\0')
+                return false;
+        }
+    }
+
+    if (*p == '*')
+    {
+        for (const char *t = s;; t++)
+        {
+            if (glob(p + 1, t))
+                return true;
+            if (*t == '\0' || *t == '/')
+                return false;
+        }
+    }
+
+    if (*p == '?')
+        return *s != '\0' && *s != '/' && glob(p + 1, s + 1);
+
+    return *p == *s && glob(p + 1, s + 1);
+}
+
+/*
+ * @brief Look the path up in .mygitattributes.
+ *
+ * @return 1 = binary, 0 = text, -1 = no rule matched.
+ */
+static int attribute(const std::string &path)
+{
+    int result = -1;
+    std::string name = path.substr(path.find_last_of('/') + 1);
+
+    auto rules = RepoState::lines(".mygitattributes");
+    for (auto &line : *rules)
+    {
+        std::istringstream ss(line);
+        std::string pattern, attr;
+
+        if (!(ss >> pattern >> attr) || pattern[0] == '#')
+            continue;
+
+        const std::string &subject = pattern.find('/') == std::string::npos ? name : path;
+        if (!glob(pattern.c_str(), subject.c_str()))
+            continue;
+
+        if (attr == "binary")
+            result = 1;
+        else if (attr == "text" || attr == "-binary")
+            result = 0;
+    }
+
+    return result;
+}
+
+/*
+ * @brief Content heuristic on the start of a file.
+ *
+ * Tabs, newlines, carriage returns, form feeds, backspaces and escapes
+ * are normal in text; other control bytes and malformed UTF-8 count
+ * against it. A UTF-8 sequence cut off by the sample end is accepted.
+ */
+bool Binary::looksBinary(const char *data, std::size_t len)
+{
+    len = std::min(len, SNIFF_BYTES);
+    const unsigned char *s = reinterpret_cast<const unsigned char *>(data);
+    std::size_t odd = 0;
+
+    for (std::size_t i = 0; i < len;)
+    {
+        unsigned char c = s[i];
+
+        if (c == 0)
+            return true;
+
+        if (c < 0x80)
+        {
+            bool control = (c < 0x20 && c != '\t' && c != '\n' && c != '\r' &&
+                            c != '\f' && c != '\b' && c != 0x1b) || c == 0x7f;
+            odd += control;
+            i++;
+            continue;
+        }
+
+        std::size_t n = (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 0;
+        bool valid = n > 0;
+        for (std::size_t k = 1; valid && k < n && i + k < len; k++)
+            valid = (s[i + k] & 0xC0) == 0x80;
+
+        if (!valid)
+        {
+            odd++;
+            i++;
+        }
+        else
+            i += n;
+    }
+
+    return odd * 10 > len;
+}
+
+/*
+ * @brief Whether a file should be treated as binary.
+ *
+ * @param path Repository-relative path (for attribute rules).
+ * @param file File to sniff if no rule applies.
+ */
+bool Binary::isBinary(const std::string &path, const std::string &file)
+{
+    int attr = attribute(path);
+    if (attr != -1)
+        return attr == 1;
+
+    std::ifstream in(file, std::ios::binary);
+    char buf[SNIFF_BYTES];
+    in.read(buf, sizeof(buf));
+
+    return looksBinary(buf, in.gcount());
+}
@@ -0,0 +1,25 @@
+/*
+Binary = decide whether a file is diffed line by line.
+    1. .mygitattributes in the working tree root, one rule per line:
+           <pattern> binary     always binary
+           <pattern> text       always text (also: -binary)
+       Later lines win; '#' starts a comment. '*' and '?' match
+       within one path component, '**' across components; a pattern
+       without '/' is matched against the file name at any depth.
+    2. Otherwise the first 8000 bytes are sniffed: a NUL byte, or
+       more than 10% control characters / invalid UTF-8, means binary.
+*/
+#ifndef BINARY_H
+#define BINARY_H
+
+#include <cstddef>
+#include <string>
+
+class Binary
+{
+public:
+    static bool isBinary(const std::string &path, const std::string &file);
+    static bool looksBinary(const char *data, std::size_t len);
+};
+
+#endif
@@ -0,0 +1,273 @@
+#include "blame.h"
+#include "commit.h"
+#include "manifest.h"
+#include "objectcache.h"
+#include "repository.h"
+#include "repostate.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <queue>
+#include <set>
+#include <tuple>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static std::string getCurrentBranch()
+{
+    std::string ref = RepoState::firstLine(".mygit/HEAD");
+    return ref.substr(ref.find_last_of('/') + 1);
+}
+
+static std::string getBranchHeadCommit(const std::string &branch)
+{
+    std::string commit = RepoState::firstLine(".mygit/branches/" + branch);
+    return commit.empty() ? "NONE" : commit;
+}
+
+// (commit, path) -> blob hash for the current blame run. The walk asks
+// about the same commits repeatedly; each manifest is parsed once.
+static std::map<std::pair<std::string, std::string>, std::string> blobHashes;
+
+// Blob hash of path in commit, or empty if the commit does not store it.
+static std::string blobHash(const std::string &commit, const std::string &path)
+{
+    auto key = std::make_pair(commit, path);
+    auto cached = blobHashes.find(key);
+    if (cached != blobHashes.end())
+        return cached->second;
+
+    auto manifest = Manifest::load(commit);
+    auto it = manifest.find(path);
+    return blobHashes[key] = it == manifest.end() ? "" : it->second.hash;
+}
+
+// Nearest commit at or below `commit` (first-parent chain) that stores path.
+static std::string nearestVersion(std::string commit, const std::string &path)
+{
+    while (!commit.empty() && commit != "NONE")
+    {
+        if (!blobHash(commit, path).empty())
+            return commit;
+
+        auto meta = ObjectCache::meta(commit);
+        if (!meta || meta->parents.empty())
+            break;
+        commit = meta->parents[0];
+    }
+    return "";
+}
+
+static unsigned long generationOf(const std::string &commit)
+{
+    auto meta = ObjectCache::meta(commit);
+    if (meta && meta->generation)
+        return meta->generation;
+    return Commit::generation(commit);
+}
+
+static std::vector<std::string> readLines(const std::string &commit, const std::string &path)
+{
+    return *ObjectCache::lines(Repository::objectDir(commit) + "/files/" + path);
+}
+
+// For each line of A, the index of the LCS-matched line in B or -1.
+static std::vector<int> matchLines(const std::vector<std::string> &A,
+                                   const std::vector<std::string> &B)
+{
+    int n = A.size(), m = B.size();
+    std::vector<std::vector<int>> dp(n + 1, std::vector<int>(m + 1));
+
+    for (int i = n - 1; i >= 0; i--)
+        for (int j = m - 1; j >= 0; j--)
+            if (A[i] == B[j])
+                dp[i][j] = dp[i + 1][j + 1] + 1;
+            else
+                dp[i][j] = std::max(dp[i + 1][j], dp[i][j + 1]);
+
+    std::vector<int> match(n, -1);
+    int i = 0, j = 0;
+    while (i < n && j < m)
+    {
+        if (A[i] == B[j])
+            match[i++] = j++;
+        else if (dp[i + 1][j] >= dp[i][j + 1])
+            i++;
+        else
+            j++;
+    }
+
+    return match;
+}
+
+static fs::path cachePath(const std::string &hash, const std::string &commit)
+{
+    return fs::path(".mygit/cache/blame") / hash / commit;
+}
+
+static bool loadCached(const std::string &hash, const std::string &commit,
+                       const std::string &path, std::size_t lineCount,
+                       std::vector<std::string> &origins)
+{
+    std::ifstream in(cachePath(hash, commit));
+    std::string line;
+
+    if (!std::getline(in, line) || line != "path " + path)
+        return false;
+
+    origins.clear();
+    while (std::getline(in, line))
+        origins.push_back(line);
+
+    return origins.size() == lineCount;
+}
+
+static void storeCached(const std::string &hash, const std::string &commit,
+                        const std::string &path, const std::vector<std::string> &origins)
+{
+    fs::path p = cachePath(hash, commit);
+    fs::create_directories(p.parent_path());
+
+    std::ofstream out(p);
+    out << "path " << path << "\n";
+    for (auto &o : origins)
+        out << o << "\n";
+}
+
+void Blame::show(const std::string &input)
+{
+    if (!Repository::exists())
+    {
+        std::cout << "Not a mygit repository.\n";
+        return;
+    }
+
+    blobHashes.clear();
+
+    std::string path = fs::path(input).lexically_normal().generic_string();
+    std::string start = nearestVersion(getBranchHeadCommit(getCurrentBranch()), path);
+
+    if (start.empty())
+    {
+        std::cout << "No committed version of " << path << "\n";
+        return;
+    }
+
+    auto finalLines = readLines(start, path);
+    std::vector<std::string> result(finalLines.size());
+
+    // commit -> (line in that commit's version, line in the final version)
+    std::map<std::string, std::vector<std::pair<int, int>>> pending;
+    std::priority_queue<std::pair<unsigned long, std::string>> queue;
+
+    // Versions whose every line was tracked; their full blame gets cached too.
+    std::vector<std::tuple<std::string, std::string, std::vector<int>>> complete;
+
+    auto hand = [&](const std::string &commit, int line, int final)
+    {
+        if (!pending.count(commit))
+            queue.push({generationOf(commit), commit});
+        pending[commit].push_back({line, final});
+    };
+
+    for (int i = 0; i < (int)finalLines.size(); i++)
+        hand(start, i, i);
+
+    int replayed = 0;
+
+    while (!queue.empty())
+    {
+        std::string commit = queue.top().second;
+        queue.pop();
+
+        auto lines = std::move(pending[commit]);
+        pending.erase(commit);
+
+        std::string hash = blobHash(commit, path);
+        auto text = readLines(commit, path);
+
+        std::vector<std::string> cached;
+        if (loadCached(hash, commit, path, text.size(), cached))
+        {
+            for (auto &[l, f] : lines)
+                result[f] = cached[l];
+            continue;
+        }
+
+        replayed++;
+
+        std::set<int> distinct;
+        for (auto &[l, f] : lines)
+            distinct.insert(l);
+        if (distinct.size() == text.size())
+        {
+            std::vector<int> finalOf(text.size());
+            for (auto &[l, f] : lines)
+                finalOf[l] = f;
+            complete.emplace_back(commit, hash, finalOf);
+        }
+
+        auto meta = ObjectCache::meta(commit);
+        std::vector<std::pair<int, int>> remaining = lines;
+
+        for (const auto &parent : meta ? meta->parents : std::vector<std::string>())
+        {
+            if (remaining.empty())
+                break;
+
+            std::string prev = nearestVersion(parent, path);
+            if (prev.empty())
+                continue;
+
+            std::vector<std::pair<int, int>> still;
+
+            if (blobHash(prev, path) == hash)
+            {
+                for (auto &[l, f] : remaining)
+                    hand(prev, l, f);
+            }
+            else
+            {
+                auto match = matchLines(text, readLines(prev, path));
+                for (auto &[l, f] : remaining)
+                {
+                    if (match[l] != -1)
+                        hand(prev, match[l], f);
+                    else
+                        still.push_back({l, f});
+                }
+            }
+
+            remaining = std::move(still);
+        }
+
+        for (auto &[l, f] : remaining)
+            result[f] = commit;
+    }
+
+    for (auto &[commit, hash, finalOf] : complete)
+    {
+        std::vector<std::string> origins;
+        for (int f : finalOf)
+            origins.push_back(result[f]);
+        storeCached(hash, commit, path, origins);
+    }
+
+    std::size_t width = 0;
+    for (auto &r : result)
+        width = std::max(width, r.size());
+
+    for (std::size_t i = 0; i < finalLines.size(); i++)
+    {
+        std::cout << std::left << std::setw(width) << result[i] << " "
+                  << std::right << std::setw(5) << i + 1 << ") " << finalLines[i] << "\n";
+    }
+
+    if (std::getenv("MYGIT_BLAME_STATS"))
+        std::cerr << "blame: " << replayed << " version(s) replayed\n";
+}
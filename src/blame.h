@@ -0,0 +1,25 @@
+/*
+Blame = for each line of <path> at HEAD, the commit that last changed it.
+A commit only stores the files staged in it, so the history of a path
+is the chain of ancestors whose manifest lists it.
+Walk (newest generation first):
+    lines of version V are matched (LCS) against the previous version
+    reached through each parent; matched lines move on to that version,
+    unmatched lines are attributed to V's commit.
+The walk ends as soon as no line is left unattributed.
+Results are cached per (blob hash, commit) in
+.mygit/cache/blame/<blob hash>/<commit>, one origin commit per line,
+so blaming again after new commits only replays the new ones.
+*/
+#ifndef BLAME_H
+#define BLAME_H
+
+#include <string>
+
+class Blame
+{
+public:
+    static void show(const std::string &path);
+};
+
+#endif
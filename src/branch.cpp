@@ -1,4 +1,5 @@
 #include "branch.h"
+#include "repostate.h"
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -7,17 +8,13 @@ namespace fs = std::filesystem;
 
 static std::string getCurrentBranch()
 {
-    std::ifstream head(".mygit/HEAD");
-    std::string ref;
-    std::getline(head, ref);
+    std::string ref = RepoState::firstLine(".mygit/HEAD");
     return ref.substr(ref.find_last_of('/') + 1);
 }
 
 static std::string getBranchHeadCommit(const std::string &branch)
 {
-    std::ifstream in(".mygit/branches/" + branch);
-    std::string commit;
-    std::getline(in, commit);
+    std::string commit = RepoState::firstLine(".mygit/branches/" + branch);
     return commit;
 }
 
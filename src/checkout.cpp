@@ -1,72 +1,87 @@
 #include "checkout.h"
+#include "repository.h"
+#include "repostate.h"
+#include "materialize.h"
+#include "sparse.h"
+#include "worktree.h"
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 namespace fs = std::filesystem;
 
 static bool indexIsEmpty()
 {
-    std::ifstream in(".mygit/index");
-    return in.peek() == std::ifstream::traits_type::eof();
+    return RepoState::lines(".mygit/index")->empty();
 }
 
 static std::string getBranchCommit(const std::string &branch)
 {
-    std::ifstream in(".mygit/branches/" + branch);
-    std::string commit;
-    std::getline(in, commit);
+    std::string commit = RepoState::firstLine(".mygit/branches/" + branch);
     return commit;
 }
 
 static std::string getCurrentBranch()
 {
-    std::ifstream head(".mygit/HEAD");
-    std::string ref;
-    std::getline(head, ref);
+    std::string ref = RepoState::firstLine(".mygit/HEAD");
     return ref.substr(ref.find_last_of('/') + 1);
 }
 
+// Calls fn(snapshotFile, relativePath) for every snapshot file in the
+// sparse set. Subtrees outside the set are never enumerated.
+template <typename Fn>
+static void forEachSparseFile(const fs::path &filesPath, Fn fn)
+{
+    for (auto it = fs::recursive_directory_iterator(filesPath);
+         it != fs::recursive_directory_iterator(); ++it)
+    {
+        fs::path rel = fs::relative(it->path(), filesPath);
+
+        if (it->is_directory())
+        {
+            if (!Sparse::includesDir(rel.generic_string()))
+                it.disable_recursion_pending();
+        }
+        else if (it->is_regular_file() && Sparse::includes(rel.generic_string()))
+        {
+            fn(it->path(), rel);
+        }
+    }
+}
+
 // Deletes only files that belong to a commit snapshot
 static void deleteTrackedFiles(const std::string &commitID)
 {
     if (commitID == "NONE" || commitID.empty())
         return;
 
-    fs::path filesPath = ".mygit/objects/" + commitID + "/files";
+    fs::path filesPath = Repository::objectDir(commitID) + "/files";
 
     if (!fs::exists(filesPath))
         return;
 
-    for (auto &entry : fs::recursive_directory_iterator(filesPath))
+    forEachSparseFile(filesPath, [](const fs::path &, const fs::path &rel)
     {
-        if (entry.is_regular_file())
-        {
-            fs::path rel = fs::relative(entry.path(), filesPath);
-
-            if (fs::exists(rel))
-                fs::remove(rel);
-        }
-    }
+        if (fs::exists(rel))
+            fs::remove(rel);
+    });
 }
 
 static void restoreSnapshot(const std::string &commitID)
 {
-    fs::path filesPath = ".mygit/objects/" + commitID + "/files";
+    fs::path filesPath = Repository::objectDir(commitID) + "/files";
 
     if (!fs::exists(filesPath))
         return;
 
-    for (auto &entry : fs::recursive_directory_iterator(filesPath))
+    std::vector<CopyJob> jobs;
+    forEachSparseFile(filesPath, [&](const fs::path &src, const fs::path &rel)
     {
-        if (entry.is_regular_file())
-        {
-            fs::path rel = fs::relative(entry.path(), filesPath);
-            if (!rel.parent_path().empty())
-                fs::create_directories(rel.parent_path());
-            fs::copy_file(entry.path(), rel, fs::copy_options::overwrite_existing);
-        }
-    }
+        jobs.push_back({src, rel});
+    });
+
+    Materialize::files(jobs);
 }
 
 
@@ -80,7 +95,20 @@ void Checkout::switchBranch(const std::string &branch)
         return;
     }
 
+    std::string elsewhere = Worktree::checkedOutElsewhere(branch);
+    if (!elsewhere.empty())
+    {
+        std::cout << "Branch '" << branch << "' is checked out at " << elsewhere << "\n";
+        return;
+    }
+
     // Step 2 — Prevent data loss
+    if (fs::exists(".mygit/MERGE_HEAD"))
+    {
+        std::cout << "A merge is in progress. Resolve conflicts, add and commit first.\n";
+        return;
+    }
+
     if (!indexIsEmpty())
     {
         std::cout << "You have staged changes. Commit or clear them before checkout.\n";
@@ -0,0 +1,153 @@
+#include "clone.h"
+#include "materialize.h"
+#include "repostate.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// The source's object directory followed by its own alternates.
+static std::vector<fs::path> objectStores(const fs::path &objects)
+{
+    std::vector<fs::path> stores{objects};
+
+    auto alternates = RepoState::lines((objects / "alternates").string());
+    for (auto &alt : *alternates)
+        if (!alt.empty())
+            stores.push_back(alt);
+
+    return stores;
+}
+
+static fs::path findCommit(const std::vector<fs::path> &stores, const std::string &commit)
+{
+    for (auto &store : stores)
+        if (fs::is_directory(store / commit))
+            return store / commit;
+    return "";
+}
+
+// Hardlinks (or reflinks/copies) every object file; returns the counts per LinkKind.
+static std::vector<std::size_t> linkObjects(const fs::path &from, const fs::path &to)
+{
+    std::vector<std::size_t> counts(3);
+
+    for (auto &entry : fs::recursive_directory_iterator(from))
+    {
+        fs::path rel = fs::relative(entry.path(), from);
+
+        if (entry.is_directory())
+            fs::create_directories(to / rel);
+        else if (entry.is_regular_file() && entry.path().extension() != ".tmp")
+        {
+            if (rel == "alternates")
+                fs::copy_file(entry.path(), to / rel, fs::copy_options::overwrite_existing);
+            else
+                counts[static_cast<int>(Materialize::link(entry.path(), to / rel))]++;
+        }
+    }
+
+    return counts;
+}
+
+/*
+ * @brief Clone a local repository.
+ *
+ * @param source Directory containing the source .mygit (main
+ *        repository or a worktree; its HEAD branch is checked out).
+ * @param dest New directory; must not exist or be empty.
+ * @param shared Use an alternates file instead of linking objects.
+ * @return Exit status.
+ */
+int Clone::run(const std::string &source, const std::string &dest, bool shared)
+{
+    fs::path srcGit = fs::path(source) / ".mygit";
+
+    if (!fs::exists(srcGit / "HEAD"))
+    {
+        std::cout << "'" << source << "' is not a mygit repository.\n";
+        return 1;
+    }
+
+    if (fs::exists(dest) && !(fs::is_directory(dest) && fs::is_empty(dest)))
+    {
+        std::cout << "'" << dest << "' already exists and is not an empty directory.\n";
+        return 1;
+    }
+
+    // Worktrees reach the shared store through symlinks; resolve them.
+    fs::path srcObjects = fs::canonical(srcGit / "objects");
+    fs::path srcMain = srcObjects.parent_path();
+    fs::path root = fs::absolute(dest).lexically_normal();
+    fs::path gitDir = root / ".mygit";
+
+    try
+    {
+        fs::create_directories(gitDir / "objects");
+        fs::create_directories(gitDir / "branches");
+        fs::create_directories(gitDir / "logs");
+
+        auto stores = objectStores(srcObjects);
+
+        if (shared)
+        {
+            std::ofstream alt(gitDir / "objects" / "alternates");
+            for (auto &store : stores)
+                alt << store.string() << "\n";
+        }
+        else
+        {
+            auto counts = linkObjects(srcObjects, gitDir / "objects");
+            std::cout << "Objects: " << counts[0] << " hardlinked, " << counts[1] << " reflinked, "
+                      << counts[2] << " copied.\n";
+            stores.insert(stores.begin(), gitDir / "objects");
+        }
+
+        for (auto &entry : fs::directory_iterator(srcMain / "branches"))
+            fs::copy_file(entry.path(), gitDir / "branches" / entry.path().filename());
+
+        fs::copy(srcMain / "logs", gitDir / "logs", fs::copy_options::recursive);
+        fs::copy_file(srcGit / "HEAD", gitDir / "HEAD");
+        std::ofstream(gitDir / "index").close();
+
+        // Check out the HEAD branch only.
+        std::string ref = RepoState::firstLine((srcGit / "HEAD").string());
+        std::string branch = ref.substr(ref.find_last_of('/') + 1);
+        std::string commit = RepoState::firstLine((gitDir / "branches" / branch).string());
+        std::size_t files = 0;
+
+        if (!commit.empty() && commit != "NONE")
+        {
+            fs::path filesPath = findCommit(stores, commit) / "files";
+
+            if (fs::exists(filesPath))
+            {
+                std::vector<CopyJob> jobs;
+                for (auto &entry : fs::recursive_directory_iterator(filesPath))
+                {
+                    if (entry.is_regular_file())
+                        jobs.push_back({entry.path(), root / fs::relative(entry.path(), filesPath)});
+                }
+
+                Materialize::files(jobs);
+                files += jobs.size();
+            }
+        }
+
+        std::cout << "Cloned into '" << dest << "'" << (shared ? " (objects shared via alternates)" : "")
+                  << ", checked out '" << branch << "' (" << files << " files).\n";
+    }
+    catch (const fs::filesystem_error &e)
+    {
+        std::cout << "Clone failed: " << e.what() << "\n";
+
+        std::error_code ec;
+        fs::remove_all(gitDir, ec);
+        return 1;
+    }
+
+    return 0;
+}
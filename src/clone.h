@@ -0,0 +1,25 @@
+/*
+Clone = new repository from a local one.
+    mygit clone [--shared] <source> <dest>
+default  : every file under the source's .mygit/objects is hardlinked
+           (else reflinked, else copied) into <dest>/.mygit/objects.
+           Object files are never modified in place, so sharing
+           their inodes is safe.
+--shared : no objects are linked at all; <dest>/.mygit/objects/alternates
+           names the source's object directory, which is searched
+           after the local one. Clone time does not depend on history
+           size, but the source store must stay where it is.
+Both copy branches, logs and HEAD, then check out the HEAD branch only.
+*/
+#ifndef CLONE_H
+#define CLONE_H
+
+#include <string>
+
+class Clone
+{
+public:
+    static int run(const std::string &source, const std::string &dest, bool shared);
+};
+
+#endif
@@ -0,0 +1,353 @@
+#include "command.h"
+#include "repostate.h"
+#include <iostream>
+#include <vector>
+#include "repository.h"
+#include "help.h"
+#include "index.h"
+#include"status.h"
+#include "commit.h"
+#include "log.h"
+#include "branch.h"
+#include "checkout.h"
+#include "diff.h"
+#include "merge.h"
+#include "sparse.h"
+#include "worktree.h"
+#include "blame.h"
+#include "fsck.h"
+#include "hash.h"
+#include "archive.h"
+#include "clone.h"
+#include "delta.h"
+#include "materialize.h"
+#include <cctype>
+
+/*
+ * @brief Value of a numeric option such as "--threads=<n>".
+ *
+ * @param arg    The whole argument.
+ * @param prefix The option name including '='.
+ * @param max    Largest accepted value.
+ * @return false unless arg starts with prefix and is followed by a
+ *         decimal number in [1, max].
+ */
+static bool numberOption(const std::string &arg, const std::string &prefix,
+                         unsigned long max, unsigned long &value)
+{
+    if (arg.rfind(prefix, 0) != 0)
+        return false;
+
+    std::string digits = arg.substr(prefix.size());
+    if (digits.empty() || digits.size() > 9)
+        return false;
+    for (char c : digits)
+        if (!std::isdigit(static_cast<unsigned char>(c)))
+            return false;
+
+    value = std::stoul(digits);
+    return value >= 1 && value <= max;
+}
+
+/*
+ * @brief Run one mygit command.
+ *
+ * argv[0] is the program name and argv[1] the command, exactly as
+ * main() receives them, so batch/server mode can feed parsed lines
+ * through the same dispatcher.
+ *
+ * @return Exit status.
+ */
+int Command::run(const std::vector<std::string> &argv)
+{
+    int argc = argv.size();
+    RepoState::beginCommand();
+
+    if (argc < 2)
+    {
+        std::cout << "Usage: mygit <command>\n";
+        std::cout << "Run 'mygit help' for available commands.\n";
+        return 0;
+    }
+
+    std::string command = argv[1];
+
+    if (command == "help")
+    {
+        Help::show();
+    }
+    else if (command == "init")
+    {
+        Repository::init();
+    }
+    else if (command == "add")
+    {
+        if (argc < 3)
+        {
+            std::cout << "Usage: mygit add <paths...>\n";
+            return 0;
+        }
+
+        std::vector<std::string> paths;
+        for (int i = 2; i < argc; i++)
+        {
+            paths.push_back(argv[i]);
+        }
+
+        Index::add(paths);
+    }
+    else if (command == "status")
+    {
+        Status::show();
+    }
+    else if (command == "commit")
+    {
+        if (argc < 3)
+        {
+            std::cout << "Usage: mygit commit \"message\"\n";
+            return 0;
+        }
+        Commit::create(argv[2]);
+    }
+    else if (command == "log")
+    {
+        Log::show();
+    }
+    else if (command == "branch")
+    {
+        if (argc == 2)
+        {
+            Branch::list();
+        }
+        else
+        {
+            Branch::create(argv[2]);
+        }
+    }
+    else if (command == "checkout")
+    {
+        if (argc < 3)
+        {
+            std::cout << "Usage: mygit checkout <branch>\n";
+            return 0;
+        }
+        Checkout::switchBranch(argv[2]);
+    }
+    else if (command == "diff")
+    {
+        DiffOptions opts;
+        std::vector<std::string> commits;
+        bool valid = true;
+        for (int i = 2; i < argc; i++)
+        {
+            if (argv[i] == "--no-renames")
+                opts.renames = false;
+            else if (argv[i] == "--find-copies")
+                opts.copies = true;
+            else if (argv[i].rfind("--rename-limit=", 0) == 0)
+            {
+                unsigned long limit;
+                valid = valid && numberOption(argv[i], "--rename-limit=", 1000000, limit);
+                if (valid)
+                    opts.renameLimit = limit;
+            }
+            else if (argv[i] == "--delta")
+                opts.delta = true;
+            else if (argv[i] == "--name-only")
+                opts.format = DiffFormat::NameOnly;
+            else if (argv[i] == "--name-status")
+                opts.format = DiffFormat::NameStatus;
+            else if (argv[i] == "--stat")
+                opts.format = DiffFormat::Stat;
+            else
+                commits.push_back(argv[i]);
+        }
+
+        if (!valid || commits.size() != 2)
+        {
+            std::cout << "Usage: mygit diff [--no-renames] [--find-copies] [--rename-limit=<1..1000000>] [--delta] [--name-only|--name-status|--stat] <commitA> <commitB>\n";
+            return 0;
+        }
+
+        return Diff::show(commits[0], commits[1], opts);
+    }
+    else if (command == "merge")
+    {
+        if (argc != 3)
+        {
+            std::cout << "Usage: mygit merge <branch>\n";
+            return 0;
+        }
+
+        Merge::run(argv[2]);
+    }
+    else if (command == "blame")
+    {
+        if (argc != 3)
+        {
+            std::cout << "Usage: mygit blame <path>\n";
+            return 0;
+        }
+
+        Blame::show(argv[2]);
+    }
+    else if (command == "fsck")
+    {
+        unsigned long threads = 0;
+        if (argc > 3 || (argc == 3 && !numberOption(argv[2], "--threads=", 1024, threads)))
+        {
+            std::cout << "Usage: mygit fsck [--threads=<1..1024>]\n";
+            return 0;
+        }
+
+        return Fsck::run(threads);
+    }
+    else if (command == "clone")
+    {
+        bool shared = false;
+        std::vector<std::string> paths;
+        for (int i = 2; i < argc; i++)
+        {
+            if (argv[i] == "--shared")
+                shared = true;
+            else
+                paths.push_back(argv[i]);
+        }
+
+        if (paths.size() != 2)
+        {
+            std::cout << "Usage: mygit clone [--shared] <source> <dest>\n";
+            return 0;
+        }
+
+        return Clone::run(paths[0], paths[1], shared);
+    }
+    else if (command == "delta")
+    {
+        std::string sub = argc >= 3 ? argv[2] : "";
+
+        if (sub == "create" && argc == 6)
+            return Delta::create(argv[3], argv[4], argv[5]);
+        if (sub == "apply" && argc == 6)
+            return Delta::patch(argv[3], argv[4], argv[5]);
+
+        std::cout << "Usage: mygit delta create <old> <new> <patch> | apply <old> <patch> <out>\n";
+        std::cout << "       <old>/<new> may be <commit>:<path>\n";
+    }
+    else if (command == "archive")
+    {
+        std::string format = "tar", rev;
+        unsigned long threads = 0;
+        bool valid = true;
+        for (int i = 2; i < argc; i++)
+        {
+            if (argv[i].rfind("--format=", 0) == 0)
+                format = argv[i].substr(9);
+            else if (argv[i].rfind("--threads=", 0) == 0)
+                valid = valid && numberOption(argv[i], "--threads=", 1024, threads);
+            else
+                rev = argv[i];
+        }
+
+        if (!valid || rev.empty())
+        {
+            std::cout << "Usage: mygit archive <commit|branch> [--format=tar|tar.zst] [--threads=<1..1024>] > out\n";
+            return 0;
+        }
+
+        return Archive::run(rev, format, threads);
+    }
+    else if (command == "hash")
+    {
+        std::string opt = argc == 3 ? argv[2] : "";
+
+        if (opt == "--self-test")
+        {
+            std::cout << "kernel: " << Hash::kernel() << "\n";
+            return Hash::selfTest() ? 0 : 1;
+        }
+        if (opt == "--bench")
+        {
+            std::cout << "kernel: " << Hash::kernel() << "\n";
+            Hash::benchmark();
+            return 0;
+        }
+
+        std::cout << "Usage: mygit hash --self-test | --bench\n";
+    }
+    else if (command == "materialize")
+    {
+        unsigned long files = 2000, size = 4096;
+        bool bench = argc >= 3 && argv[2] == "--bench";
+
+        for (int i = 3; bench && i < argc; i++)
+        {
+            if (!numberOption(argv[i], "--files=", 1000000, files) &&
+                !numberOption(argv[i], "--size=", 64ul << 20, size))
+                bench = false;
+        }
+
+        if (!bench)
+        {
+            std::cout << "Usage: mygit materialize --bench [--files=<1..1000000>] [--size=<1..67108864>]\n";
+            return 0;
+        }
+
+        Materialize::benchmark(files, size);
+    }
+    else if (command == "sparse-checkout")
+    {
+        std::string sub = argc >= 3 ? argv[2] : "";
+
+        std::vector<std::string> patterns;
+        bool force = false;
+        for (int i = 3; sub == "set" && i < argc; i++)
+        {
+            if (argv[i] == "--force")
+                force = true;
+            else
+                patterns.push_back(argv[i]);
+        }
+
+        if (sub == "set" && !patterns.empty())
+        {
+            Sparse::set(patterns, force);
+        }
+        else if (sub == "list")
+        {
+            Sparse::list();
+        }
+        else if (sub == "disable")
+        {
+            Sparse::disable();
+        }
+        else
+        {
+            std::cout << "Usage: mygit sparse-checkout set [--force] <dirs...> | list | disable\n";
+        }
+    }
+    else if (command == "worktree")
+    {
+        std::string sub = argc >= 3 ? argv[2] : "";
+
+        if (sub == "add" && argc == 5)
+        {
+            Worktree::add(argv[3], argv[4]);
+        }
+        else if (sub == "list")
+        {
+            Worktree::list();
+        }
+        else
+        {
+            std::cout << "Usage: mygit worktree add <dir> <branch> | list\n";
+        }
+    }
+    else
+    {
+        std::cout << "Unknown command: " << command << "\n";
+        std::cout << "Run 'mygit help' for available commands.\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,13 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <string>
+#include <vector>
+
+class Command
+{
+public:
+    static int run(const std::vector<std::string> &argv);
+};
+
+#endif
@@ -1,10 +1,26 @@
 #include "commit.h"
+#include "repostate.h"
 #include "repository.h"
+#include "manifest.h"
+#include "materialize.h"
+#include "objectcache.h"
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <algorithm>
 #include <chrono>
 #include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#endif
 
 namespace fs = std::filesystem;
 
@@ -12,31 +28,191 @@ static std::string generateCommitID()
 {
     auto now = std::chrono::system_clock::now();
     auto time = std::chrono::system_clock::to_time_t(now);
-    return std::to_string(time);
+    std::string id = std::to_string(time);
+
+    // Two commits in the same second (a merge right after a commit, or
+    // commits from several worktrees) must not share a snapshot directory.
+    // create_directory is atomic, so it also reserves the ID. IDs taken
+    // in an alternate object store are skipped as well.
+    std::string candidate = id;
+    for (int n = 1; fs::exists(Repository::objectDir(candidate)) ||
+                    !fs::create_directory(".mygit/objects/" + candidate); n++)
+        candidate = id + "-" + std::to_string(n);
+    return candidate;
+}
+
+// Per-worktree commit lock; .mygit/HEAD and index belong to one worktree,
+// so commits in different worktrees never wait on each other.
+// The lock directory holds the owner's pid. A lock whose owner is gone
+// (killed mid-commit) is moved aside and taken over.
+static const char *LOCK_PATH = ".mygit/commit.lock";
+
+static long currentPid()
+{
+#ifdef _WIN32
+    return _getpid();
+#else
+    return getpid();
+#endif
 }
 
+static bool lockIsStale()
+{
+    std::ifstream in(std::string(LOCK_PATH) + "/pid");
+    long pid = 0;
+
+    // No pid yet: the owner may be between mkdir and writing it.
+    if (!(in >> pid))
+    {
+        std::error_code ec;
+        auto age = fs::file_time_type::clock::now() - fs::last_write_time(LOCK_PATH, ec);
+        return !ec && age > std::chrono::seconds(10);
+    }
+
+#ifdef _WIN32
+    return false;
+#else
+    return kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH;
+#endif
+}
+
+struct CommitLock
+{
+    bool held;
+
+    CommitLock() : held(acquire())
+    {
+        if (!held && lockIsStale())
+        {
+            // Rename is atomic: of two processes reclaiming the same
+            // stale lock, only one moves it away.
+            std::error_code ec;
+            std::string aside = std::string(LOCK_PATH) + ".stale-" + std::to_string(currentPid());
+            fs::rename(LOCK_PATH, aside, ec);
+            if (!ec)
+            {
+                fs::remove_all(aside, ec);
+                std::cout << "Removed stale commit lock.\n";
+            }
+            held = acquire();
+        }
+    }
+
+    ~CommitLock()
+    {
+        if (held)
+            fs::remove_all(LOCK_PATH);
+    }
+
+    static bool acquire()
+    {
+        if (!fs::create_directory(LOCK_PATH))
+            return false;
+        std::ofstream(std::string(LOCK_PATH) + "/pid") << currentPid() << "\n";
+        return true;
+    }
+};
+
 static std::string getCurrentBranch()
 {
-    std::ifstream head(".mygit/HEAD");
-    std::string ref;
-    std::getline(head, ref);
+    std::string ref = RepoState::firstLine(".mygit/HEAD");
     return ref.substr(ref.find_last_of('/') + 1);
 }
 
 static std::string getBranchHeadCommit(const std::string &branch)
 {
-    std::ifstream in(".mygit/branches/" + branch);
-    std::string commit;
-    std::getline(in, commit);
+    std::string commit = RepoState::firstLine(".mygit/branches/" + branch);
     return commit.empty() ? "NONE" : commit;
 }
 
+static std::string readMergeHead()
+{
+    return RepoState::firstLine(".mygit/MERGE_HEAD");
+}
+
+// Merge results outside the sparse set are not on disk; merge lists
+// where each one is (path<TAB>file).
+static std::unordered_map<std::string, std::string> readMergeSources()
+{
+    std::unordered_map<std::string, std::string> sources;
+    for (auto &line : *RepoState::lines(".mygit/MERGE_SOURCES"))
+    {
+        auto tab = line.find('\t');
+        if (tab != std::string::npos)
+            sources[line.substr(0, tab)] = line.substr(tab + 1);
+    }
+    return sources;
+}
+
 static void updateBranchHead(const std::string &branch, const std::string &commitID)
 {
     std::ofstream out(".mygit/branches/" + branch);
     out << commitID;
 }
 
+/*
+ * @brief Generation number of a commit.
+ *
+ * Roots have generation 1, every other commit is one more than its
+ * highest parent. Stored in meta at commit time; commits written
+ * before that are computed from their parents.
+ *
+ * @param commitID The commit to look up, or NONE/empty.
+ * @return The generation, 0 for NONE or a missing commit.
+ */
+unsigned long Commit::generation(const std::string &commitID)
+{
+    std::vector<std::string> stack{commitID};
+    std::unordered_map<std::string, unsigned long> known;
+
+    while (!stack.empty())
+    {
+        std::string id = stack.back();
+
+        if (id.empty() || id == "NONE" || known.count(id))
+        {
+            stack.pop_back();
+            continue;
+        }
+
+        auto meta = ObjectCache::meta(id);
+        if (!meta)
+        {
+            known[id] = 0;
+            stack.pop_back();
+            continue;
+        }
+
+        if (meta->generation)
+        {
+            known[id] = meta->generation;
+            stack.pop_back();
+            continue;
+        }
+
+        bool ready = true;
+        unsigned long gen = 0;
+        for (auto &p : meta->parents)
+        {
+            if (!known.count(p))
+            {
+                stack.push_back(p);
+                ready = false;
+            }
+            else
+                gen = std::max(gen, known[p]);
+        }
+
+        if (ready)
+        {
+            known[id] = gen + 1;
+            stack.pop_back();
+        }
+    }
+
+    return known[commitID];
+}
+
 void Commit::create(const std::string &message)
 {
     if (!Repository::exists())
@@ -45,8 +221,16 @@ void Commit::create(const std::string &message)
         return;
     }
 
-    std::ifstream index(".mygit/index");
-    if (index.peek() == std::ifstream::traits_type::eof())
+    CommitLock lock;
+    if (!lock.held)
+    {
+        std::cout << "Another commit is running in this worktree (.mygit/commit.lock).\n";
+        std::cout << "If no mygit process is running, remove .mygit/commit.lock and retry.\n";
+        return;
+    }
+
+    auto index = RepoState::lines(".mygit/index");
+    if (index->empty())
     {
         std::cout << "No files staged for commit.\n";
         return;
@@ -55,32 +239,55 @@ void Commit::create(const std::string &message)
     std::string commitID = generateCommitID();
     std::string branch = getCurrentBranch();
     std::string parent = getBranchHeadCommit(branch);
+    std::string mergeParent = readMergeHead();
 
     fs::path commitPath = ".mygit/objects/" + commitID;
-    fs::create_directory(commitPath);
-    fs::create_directories(commitPath / "files");
 
-    // Copy staged files
-    std::string file;
-    while (std::getline(index, file))
+    // Until the branch moves nothing refers to the snapshot, so a failure
+    // here removes it and leaves the index and MERGE_HEAD for a retry.
+    try
     {
-        if (file.empty())
-            continue;
+        fs::create_directories(commitPath / "files");
 
-        fs::path src = file;
-        fs::path dest = commitPath / "files" / file;
+        std::unordered_map<std::string, std::string> sources;
+        if (!mergeParent.empty())
+            sources = readMergeSources();
 
-        fs::create_directories(dest.parent_path());
-        fs::copy_file(src, dest, fs::copy_options::overwrite_existing);
-    }
+        // Copy staged files
+        std::vector<CopyJob> jobs;
+        for (const auto &file : *index)
+        {
+            if (file.empty())
+                continue;
 
-    // Write metadata
-    std::ofstream meta(commitPath / "meta");
-    meta << "commit " << commitID << "\n";
-    meta << "parent " << parent << "\n";
-    meta << "branch " << branch << "\n";
-    meta << "message " << message << "\n";
-    meta.close();
+            auto it = sources.find(file);
+            jobs.push_back({it == sources.end() ? fs::path(file) : fs::path(it->second),
+                            commitPath / "files" / file});
+        }
+        Materialize::files(jobs);
+
+        // Write metadata
+        std::ofstream meta(commitPath / "meta");
+        meta << "commit " << commitID << "\n";
+        meta << "parent " << parent << "\n";
+        if (!mergeParent.empty())
+            meta << "parent2 " << mergeParent << "\n";
+        meta << "generation "
+             << std::max(generation(parent), generation(mergeParent)) + 1 << "\n";
+        meta << "branch " << branch << "\n";
+        meta << "message " << message << "\n";
+        meta.close();
+
+        if (!meta || !Manifest::write(commitID))
+            throw std::runtime_error("cannot write " + commitPath.string());
+    }
+    catch (const std::exception &e)
+    {
+        std::error_code ec;
+        fs::remove_all(commitPath, ec);
+        std::cout << "Commit failed: " << e.what() << "\n";
+        return;
+    }
 
     // Update branch head
     updateBranchHead(branch, commitID);
@@ -92,5 +299,10 @@ void Commit::create(const std::string &message)
     // Clear index
     std::ofstream clear(".mygit/index", std::ios::trunc);
 
+    // Merge concluded
+    fs::remove(".mygit/MERGE_HEAD");
+    fs::remove(".mygit/MERGE_SOURCES");
+    fs::remove_all(".mygit/merge-results");
+
     std::cout << "Committed as " << commitID << "\n";
 }
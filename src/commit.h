@@ -6,6 +6,8 @@ Each commit has:
     parent_commit_id (or NONE)
     timestamp
     commit_message
+    generation (1 + highest parent generation)
+    parent2 (merge commits only)
 
 list of tracked files (snapshot)*/
 #ifndef COMMIT_H
@@ -17,6 +19,7 @@ class Commit
 {
 public:
     static void create(const std::string &message);
+    static unsigned long generation(const std::string &commitID);
 };
 
 #endif
@@ -0,0 +1,296 @@
+#include "delta.h"
+#include "hash.h"
+#include "repository.h"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static const std::size_t WINDOW = 16;
+static const std::uint64_t BASE = 257;
+static const std::uint32_t NO_POS = UINT32_MAX;
+static const char MAGIC[4] = {'M', 'G', 'D', '1'};
+
+static void putVarint(std::string &out, std::uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        out += static_cast<char>((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    out += static_cast<char>(v);
+}
+
+static std::uint64_t getVarint(const std::string &in, std::size_t &pos)
+{
+    std::uint64_t v = 0;
+    for (int shift = 0; pos < in.size() && shift < 64; shift += 7)
+    {
+        unsigned char c = in[pos++];
+        v |= static_cast<std::uint64_t>(c & 0x7F) << shift;
+        if (!(c & 0x80))
+            return v;
+    }
+    throw std::runtime_error("corrupt delta");
+}
+
+static std::uint64_t windowHash(const unsigned char *p)
+{
+    std::uint64_t h = 0;
+    for (std::size_t i = 0; i < WINDOW; i++)
+        h = h * BASE + p[i];
+    return h;
+}
+
+static std::size_t slot(std::uint64_t h, int bits)
+{
+    return (h * 0x9E3779B97F4A7C15ULL) >> (64 - bits);
+}
+
+/*
+ * @brief Compute a delta that turns old into new.
+ *
+ * Old must be below 4 GiB (offsets are indexed as 32-bit).
+ */
+std::string Delta::encode(const char *oldData, std::size_t oldLen,
+                          const char *newData, std::size_t newLen)
+{
+    const unsigned char *o = reinterpret_cast<const unsigned char *>(oldData);
+    const unsigned char *n = reinterpret_cast<const unsigned char *>(newData);
+
+    std::string out(MAGIC, sizeof(MAGIC));
+    putVarint(out, oldLen);
+    std::uint64_t check = Hash::fast64(oldData, oldLen);
+    for (int i = 0; i < 8; i++)
+        out += static_cast<char>(check >> (8 * i));
+    putVarint(out, newLen);
+
+    auto insert = [&](std::size_t from, std::size_t to)
+    {
+        if (to > from)
+        {
+            putVarint(out, (to - from) << 1);
+            out.append(newData + from, to - from);
+        }
+    };
+
+    // Index old every WINDOW bytes; the first occurrence wins.
+    int bits = 10;
+    while (bits < 26 && (std::size_t(1) << bits) < 2 * (oldLen / WINDOW))
+        bits++;
+    std::vector<std::uint32_t> table(std::size_t(1) << bits, NO_POS);
+
+    for (std::size_t i = 0; i + WINDOW <= oldLen; i += WINDOW)
+    {
+        std::size_t s = slot(windowHash(o + i), bits);
+        if (table[s] == NO_POS)
+            table[s] = i;
+    }
+
+    std::uint64_t drop = 1; // BASE^(WINDOW-1), weight of the byte leaving the window
+    for (std::size_t i = 1; i < WINDOW; i++)
+        drop *= BASE;
+
+    std::size_t pos = 0, anchor = 0;
+    std::uint64_t h = newLen >= WINDOW ? windowHash(n) : 0;
+
+    while (pos + WINDOW <= newLen)
+    {
+        std::uint32_t cand = table[slot(h, bits)];
+
+        if (cand != NO_POS && std::memcmp(o + cand, n + pos, WINDOW) == 0)
+        {
+            std::size_t start = pos, from = cand;
+            while (start > anchor && from > 0 && o[from - 1] == n[start - 1])
+            {
+                start--;
+                from--;
+            }
+
+            std::size_t end = pos + WINDOW, oldEnd = cand + WINDOW;
+            while (end < newLen && oldEnd < oldLen && o[oldEnd] == n[end])
+            {
+                end++;
+                oldEnd++;
+            }
+
+            insert(anchor, start);
+            putVarint(out, ((end - start) << 1) | 1);
+            putVarint(out, from);
+
+            pos = anchor = end;
+            if (pos + WINDOW <= newLen)
+                h = windowHash(n + pos);
+            continue;
+        }
+
+        if (pos + WINDOW < newLen)
+            h = (h - n[pos] * drop) * BASE + n[pos + WINDOW];
+        pos++;
+    }
+
+    insert(anchor, newLen);
+    return out;
+}
+
+static std::size_t readHeader(const std::string &delta, std::uint64_t &oldLen,
+                              std::uint64_t &check, std::uint64_t &newLen)
+{
+    if (delta.size() < sizeof(MAGIC) || delta.compare(0, sizeof(MAGIC), MAGIC, sizeof(MAGIC)) != 0)
+        throw std::runtime_error("not a mygit delta");
+
+    std::size_t pos = sizeof(MAGIC);
+    oldLen = getVarint(delta, pos);
+    if (pos + sizeof(check) > delta.size())
+        throw std::runtime_error("corrupt delta");
+    check = 0;
+    for (int i = 7; i >= 0; i--)
+        check = check << 8 | static_cast<unsigned char>(delta[pos + i]);
+    pos += sizeof(check);
+    newLen = getVarint(delta, pos);
+    return pos;
+}
+
+/*
+ * @brief Rebuild the new version from old and a delta.
+ *
+ * @throws std::runtime_error if the delta is corrupt or was computed
+ *         against a different old version.
+ */
+std::string Delta::apply(const char *oldData, std::size_t oldLen, const std::string &delta)
+{
+    std::uint64_t expectOld, check, newLen;
+    std::size_t pos = readHeader(delta, expectOld, check, newLen);
+
+    if (expectOld != oldLen || check != Hash::fast64(oldData, oldLen))
+        throw std::runtime_error("delta was made against a different base");
+
+    std::string out;
+    out.reserve(newLen);
+
+    while (pos < delta.size())
+    {
+        std::uint64_t op = getVarint(delta, pos);
+        std::uint64_t len = op >> 1;
+
+        if (op & 1)
+        {
+            std::uint64_t from = getVarint(delta, pos);
+            if (from > oldLen || len > oldLen - from)
+                throw std::runtime_error("corrupt delta");
+            out.append(oldData + from, len);
+        }
+        else
+        {
+            if (len > delta.size() - pos)
+                throw std::runtime_error("corrupt delta");
+            out.append(delta, pos, len);
+            pos += len;
+        }
+    }
+
+    if (out.size() != newLen)
+        throw std::runtime_error("corrupt delta");
+    return out;
+}
+
+DeltaStats Delta::stats(const std::string &delta)
+{
+    DeltaStats s;
+    std::uint64_t oldLen, check, newLen;
+    std::size_t pos = readHeader(delta, oldLen, check, newLen);
+    s.size = delta.size();
+
+    while (pos < delta.size())
+    {
+        std::uint64_t op = getVarint(delta, pos);
+        std::uint64_t len = op >> 1;
+
+        if (op & 1)
+        {
+            getVarint(delta, pos);
+            s.copies++;
+            s.copiedBytes += len;
+        }
+        else
+        {
+            pos += len;
+            s.inserts++;
+            s.insertedBytes += len;
+        }
+    }
+
+    return s;
+}
+
+// "<commit>:<path>" names a snapshot file, anything else a plain file.
+static std::string readSpec(const std::string &spec)
+{
+    fs::path file = spec;
+    std::size_t colon = spec.find(':');
+
+    if (colon != std::string::npos && colon > 0)
+    {
+        std::string dir = Repository::objectDir(spec.substr(0, colon));
+        if (fs::is_directory(dir))
+            file = fs::path(dir) / "files" / spec.substr(colon + 1);
+    }
+
+    std::ifstream in(file, std::ios::binary);
+    if (!in)
+        throw std::runtime_error("cannot read " + spec);
+
+    std::ostringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+static void writeFile(const std::string &path, const std::string &data)
+{
+    std::ofstream out(path, std::ios::binary);
+    out.write(data.data(), data.size());
+    if (!out)
+        throw std::runtime_error("cannot write " + path);
+}
+
+int Delta::create(const std::string &oldSpec, const std::string &newSpec, const std::string &out)
+{
+    try
+    {
+        std::string oldData = readSpec(oldSpec), newData = readSpec(newSpec);
+        std::string delta = encode(oldData.data(), oldData.size(), newData.data(), newData.size());
+        writeFile(out, delta);
+
+        DeltaStats s = stats(delta);
+        std::cout << "Wrote " << out << ": " << s.size << " bytes for " << newData.size() << " ("
+                  << s.copies << " copies, " << s.insertedBytes << " bytes inserted)\n";
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << "delta: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+int Delta::patch(const std::string &oldSpec, const std::string &delta, const std::string &out)
+{
+    try
+    {
+        std::string oldData = readSpec(oldSpec);
+        writeFile(out, apply(oldData.data(), oldData.size(), readSpec(delta)));
+        std::cout << "Wrote " << out << "\n";
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << "delta: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+/*
+Delta = byte-level difference between two versions of a file
+(xdelta-style copy/insert encoding).
+    encode(old, new)   -> delta: ops that rebuild new from old
+    apply(old, delta)  -> new; throws if delta was made from another old
+Format: "MGD1", varint old size, fast64 of old (8 bytes, little
+endian), varint new size, then ops until the end:
+    varint (len << 1 | 1), varint offset   copy len bytes of old
+    varint (len << 1),     len bytes       insert literal bytes
+Matching: old is indexed every 16 bytes by a rolling hash; new is
+scanned byte by byte, hits are verified and extended both ways.
+    mygit delta create <old> <new> <patch>
+    mygit delta apply  <old> <patch> <out>
+<old>/<new> are files or <commit>:<path> snapshot entries.
+*/
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <cstddef>
+#include <string>
+
+struct DeltaStats
+{
+    std::size_t copies = 0, copiedBytes = 0;
+    std::size_t inserts = 0, insertedBytes = 0;
+    std::size_t size = 0;
+};
+
+class Delta
+{
+public:
+    static std::string encode(const char *oldData, std::size_t oldLen,
+                              const char *newData, std::size_t newLen);
+    static std::string apply(const char *oldData, std::size_t oldLen, const std::string &delta);
+    static DeltaStats stats(const std::string &delta);
+
+    static int create(const std::string &oldSpec, const std::string &newSpec, const std::string &out);
+    static int patch(const std::string &oldSpec, const std::string &delta, const std::string &out);
+};
+
+#endif
@@ -1,41 +1,44 @@
 #include "diff.h"
+#include "binary.h"
+#include "delta.h"
+#include "repository.h"
+#include "objectcache.h"
+#include "manifest.h"
+#include <algorithm>
+#include <cstdint>
 #include <filesystem>
 #include <unordered_map>
+#include <unordered_set>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <vector>
 
 namespace fs = std::filesystem;
 
+using ManifestMap = std::map<std::string, ManifestEntry>;
+
+// Paths come from the manifest, so no directory walk is needed.
 static std::unordered_map<std::string, fs::path>
-buildFileMap(const std::string &commit)
+buildFileMap(const std::string &commit, const ManifestMap &manifest)
 {
     std::unordered_map<std::string, fs::path> files;
 
-    fs::path root = ".mygit/objects/" + commit + "/files";
+    fs::path root = Repository::objectDir(commit) + "/files";
 
-    for (auto &entry : fs::recursive_directory_iterator(root))
-    {
-        if (entry.is_regular_file())
-        {
-            fs::path rel = fs::relative(entry.path(), root);
-            files[rel.string()] = entry.path();
-        }
-    }
+    for (auto &[path, e] : manifest)
+        files[path] = root / path;
 
     return files;
 }
+
 // longest common Subsequence.(LCS)
-static std::vector<std::string> readLines(const fs::path &file)
+// Snapshot files are immutable, so lines come from the shared object cache.
+static const std::vector<std::string> &readLines(const fs::path &file,
+                                                 std::shared_ptr<const std::vector<std::string>> &holder)
 {
-    std::ifstream in(file);
-    std::vector<std::string> lines;
-    std::string line;
-
-    while (std::getline(in, line))
-        lines.push_back(line);
-
-    return lines;
+    holder = ObjectCache::lines(file.string());
+    return *holder;
 }
 
 // Longest common subsequence Table:
@@ -77,46 +80,630 @@ static void printDiff(const std::vector<std::string> &A,const std::vector<std::s
     }
 }
 
-void Diff::show(const std::string &A,
-                const std::string &B)
+// Rename / copy detection:
+// 1. exact: same manifest hash on both sides, O(n) via a hash map.
+// 2. similar: MinHash signature over the set of lines, LSH buckets
+//    propose candidate pairs; only the best renameLimit are kept (a
+//    bounded heap, so memory and sorting never exceed the limit) and
+//    verified with an exact line-multiset similarity.
+static const int MINHASH_SIZE = 32;
+static const int LSH_BANDS = 8;
+static const int LSH_ROWS = MINHASH_SIZE / LSH_BANDS;
+static const int MIN_SIMILARITY = 50;
+
+using Signature = std::vector<std::uint64_t>;
+
+static std::uint64_t mix(std::uint64_t x)
 {
-    auto filesA = buildFileMap(A);
-    auto filesB = buildFileMap(B);
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
 
-    std::unordered_map<std::string, bool> visited;
+static Signature minHash(const std::vector<std::string> &lines)
+{
+    Signature sig(MINHASH_SIZE, UINT64_MAX);
+    std::hash<std::string> h;
 
-    for (auto &[path, fileA] : filesA)
+    for (auto &line : lines)
     {
-        visited[path] = true;
+        std::uint64_t base = h(line);
+        for (int k = 0; k < MINHASH_SIZE; k++)
+            sig[k] = std::min(sig[k], mix(base ^ (0x2545f4914f6cdd1dULL * (k + 1))));
+    }
+
+    return sig;
+}
+
+// Percentage of lines shared by both files, counted as multisets.
+static int similarity(const std::vector<std::string> &a, const std::vector<std::string> &b)
+{
+    if (a.empty() && b.empty())
+        return 100;
+
+    std::unordered_map<std::string, int> count;
+    for (auto &l : a)
+        count[l]++;
+
+    std::size_t common = 0;
+    for (auto &l : b)
+    {
+        auto it = count.find(l);
+        if (it != count.end() && it->second > 0)
+        {
+            it->second--;
+            common++;
+        }
+    }
+
+    return static_cast<int>(200 * common / (a.size() + b.size()));
+}
 
+// similar = false stops after the exact step, so no file is opened.
+static std::vector<Pairing> detectRenames(const std::unordered_map<std::string, fs::path> &filesA,
+                                          const std::unordered_map<std::string, fs::path> &filesB,
+                                          ManifestMap &manifestA, ManifestMap &manifestB,
+                                          const DiffOptions &opts, bool similar = true)
+{
+    std::vector<Pairing> result;
+    if (!opts.renames)
+        return result;
+
+    std::vector<std::string> deleted, added;
+    for (auto &[path, f] : filesA)
         if (!filesB.count(path))
+            deleted.push_back(path);
+    for (auto &[path, f] : filesB)
+        if (!filesA.count(path))
+            added.push_back(path);
+
+    std::sort(deleted.begin(), deleted.end());
+    std::sort(added.begin(), added.end());
+
+    if (added.empty() || (deleted.empty() && !opts.copies))
+        return result;
+
+    // Sources: deleted files, plus every old file when looking for copies.
+    std::vector<std::string> sources = deleted;
+    std::unordered_set<std::string> isDeleted(deleted.begin(), deleted.end());
+    if (opts.copies)
+    {
+        for (auto &[path, f] : filesA)
+            if (!isDeleted.count(path))
+                sources.push_back(path);
+    }
+
+    std::unordered_set<std::string> usedSource, matched;
+
+    // Step 1: exact content matches
+    std::unordered_map<std::string, std::vector<std::string>> byHash;
+    for (auto &src : sources)
+        byHash[manifestA[src].hash].push_back(src);
+
+    for (auto &dst : added)
+    {
+        auto it = byHash.find(manifestB[dst].hash);
+        if (it == byHash.end())
+            continue;
+
+        for (auto &src : it->second)
         {
-            std::cout << "Deleted: " << path << "\n";
+            bool rename = isDeleted.count(src) && !usedSource.count(src);
+            if (rename || opts.copies)
+            {
+                result.push_back({src, dst, 100, !rename});
+                if (rename)
+                    usedSource.insert(src);
+                matched.insert(dst);
+                break;
+            }
         }
-        else
+    }
+
+    if (!similar)
+        return result;
+
+    // Step 2: similarity via MinHash + LSH buckets
+    std::unordered_map<std::string, Signature> sigs;
+    std::unordered_map<std::uint64_t, std::vector<std::string>> buckets;
+
+    auto bandKey = [](const Signature &sig, int band)
+    {
+        std::uint64_t key = mix(band);
+        for (int r = 0; r < LSH_ROWS; r++)
+            key = mix(key ^ sig[band * LSH_ROWS + r]);
+        return key;
+    };
+
+    for (auto &src : sources)
+    {
+        if (usedSource.count(src) || Binary::isBinary(src, filesA.at(src).string()))
+            continue;
+        auto lines = ObjectCache::lines(filesA.at(src).string());
+        if (lines->empty())
+            continue;
+        sigs[src] = minHash(*lines);
+        for (int b = 0; b < LSH_BANDS; b++)
+            buckets[bandKey(sigs[src], b)].push_back(src);
+    }
+
+    struct Candidate
+    {
+        int estimate;
+        std::string from, to;
+    };
+
+    auto better = [](const Candidate &x, const Candidate &y)
+    {
+        if (x.estimate != y.estimate)
+            return x.estimate > y.estimate;
+        return x.to != y.to ? x.to < y.to : x.from < y.from;
+    };
+
+    // Heap ordered by better(): the front is the worst kept candidate.
+    std::vector<Candidate> candidates;
+    std::size_t proposed = 0;
+
+    auto propose = [&](int estimate, const std::string &from, const std::string &to)
+    {
+        proposed++;
+        if (candidates.size() < opts.renameLimit)
         {
-            fs::path fileB = filesB[path];
+            candidates.push_back({estimate, from, to});
+            std::push_heap(candidates.begin(), candidates.end(), better);
+        }
+        else if (!candidates.empty() && better({estimate, from, to}, candidates.front()))
+        {
+            std::pop_heap(candidates.begin(), candidates.end(), better);
+            candidates.back() = {estimate, from, to};
+            std::push_heap(candidates.begin(), candidates.end(), better);
+        }
+    };
+
+    for (auto &dst : added)
+    {
+        if (matched.count(dst) || Binary::isBinary(dst, filesB.at(dst).string()))
+            continue;
+        auto lines = ObjectCache::lines(filesB.at(dst).string());
+        if (lines->empty())
+            continue;
+
+        Signature sig = minHash(*lines);
+        std::unordered_set<std::string> seen;
 
-            auto oldLines = readLines(fileA);
-            auto newLines = readLines(fileB);
+        for (int b = 0; b < LSH_BANDS; b++)
+        {
+            auto it = buckets.find(bandKey(sig, b));
+            if (it == buckets.end())
+                continue;
 
-            if (oldLines != newLines)
+            for (auto &src : it->second)
             {
-                std::cout << "\n--- " << path << "\n";
-                std::cout << "+++ " << path << "\n";
+                if (!seen.insert(src).second)
+                    continue;
 
-                auto dp = buildLCS(oldLines, newLines);
-                printDiff(oldLines, newLines, dp,
-                          oldLines.size(), newLines.size());
+                int same = 0;
+                for (int k = 0; k < MINHASH_SIZE; k++)
+                    same += sigs[src][k] == sig[k];
+                propose(100 * same / MINHASH_SIZE, src, dst);
             }
         }
     }
 
+    std::sort_heap(candidates.begin(), candidates.end(), better);
+
+    if (proposed > candidates.size())
+    {
+        std::cout << "warning: only checking the best " << opts.renameLimit << " of "
+                  << proposed << " rename candidates (--rename-limit)\n";
+    }
+
+    std::vector<Pairing> verified;
+    for (auto &c : candidates)
+    {
+        int score = similarity(*ObjectCache::lines(filesA.at(c.from).string()),
+                               *ObjectCache::lines(filesB.at(c.to).string()));
+        if (score >= MIN_SIMILARITY)
+            verified.push_back({c.from, c.to, score, !isDeleted.count(c.from)});
+    }
+
+    std::stable_sort(verified.begin(), verified.end(), [](const Pairing &x, const Pairing &y)
+    {
+        return x.score > y.score;
+    });
+
+    for (auto &p : verified)
+    {
+        if (matched.count(p.to))
+            continue;
+        if (!p.copy && usedSource.count(p.from))
+        {
+            if (!opts.copies)
+                continue;
+            p.copy = true;
+        }
+
+        result.push_back(p);
+        matched.insert(p.to);
+        if (!p.copy)
+            usedSource.insert(p.from);
+    }
+
+    return result;
+}
+
+// Binary files: sizes and content hashes, plus a delta summary on request.
+static void printBinaryChange(const std::string &pathA, const fs::path &fileA, const ManifestEntry &a,
+                              const std::string &pathB, const fs::path &fileB, const ManifestEntry &b,
+                              const DiffOptions &opts)
+{
+    std::cout << "\nBinary: " << (pathA == pathB ? pathA : pathA + " -> " + pathB)
+              << " (" << a.size << " -> " << b.size << " bytes, "
+              << a.hash.substr(0, 8) << " -> " << b.hash.substr(0, 8) << ")\n";
+
+    if (!opts.delta)
+        return;
+
+    auto oldBlob = ObjectCache::blob(fileA.string());
+    auto newBlob = ObjectCache::blob(fileB.string());
+    DeltaStats d = Delta::stats(Delta::encode(oldBlob->data(), oldBlob->size(),
+                                              newBlob->data(), newBlob->size()));
+
+    std::cout << "  delta: " << d.copies << " copied ranges (" << d.copiedBytes << " bytes), "
+              << d.insertedBytes << " bytes inserted, " << d.size << "-byte delta ("
+              << (b.size ? 100 * d.size / b.size : 0) << "% of new)\n";
+}
+
+static void printFileDiff(const std::string &pathA, const fs::path &fileA, const ManifestEntry &a,
+                          const std::string &pathB, const fs::path &fileB, const ManifestEntry &b,
+                          const DiffOptions &opts)
+{
+    // Same content hash: nothing to show, no need to open either file.
+    if (a.hash == b.hash && a.size == b.size && !a.hash.empty())
+        return;
+
+    if (Binary::isBinary(pathA, fileA.string()) || Binary::isBinary(pathB, fileB.string()))
+    {
+        printBinaryChange(pathA, fileA, a, pathB, fileB, b, opts);
+        return;
+    }
+
+    std::shared_ptr<const std::vector<std::string>> holdA, holdB;
+    const auto &oldLines = readLines(fileA, holdA);
+    const auto &newLines = readLines(fileB, holdB);
+
+    if (oldLines != newLines)
+    {
+        std::cout << "\n--- " << pathA << "\n";
+        std::cout << "+++ " << pathB << "\n";
+
+        auto dp = buildLCS(oldLines, newLines);
+        printDiff(oldLines, newLines, dp,
+                  oldLines.size(), newLines.size());
+    }
+}
+
+// ---- summary formats: --name-only, --name-status, --stat ----
+
+struct Change
+{
+    char status; // A, D, M, R, C
+    std::string from, to;
+    int score;
+};
+
+/*
+ * @brief Number of inserted and deleted lines between two versions.
+ *
+ * Only counts, never an edit script: common prefix/suffix are
+ * trimmed, lines are interned to integers, lines found on one side
+ * only are counted directly, and Myers' O((N+M)D) search with O(N+M)
+ * memory runs on what is left.
+ */
+static void countLines(const std::vector<std::string> &A, const std::vector<std::string> &B,
+                       std::size_t &insertions, std::size_t &deletions)
+{
+    std::size_t begin = 0, endA = A.size(), endB = B.size();
+    while (begin < endA && begin < endB && A[begin] == B[begin])
+        begin++;
+    while (endA > begin && endB > begin && A[endA - 1] == B[endB - 1])
+    {
+        endA--;
+        endB--;
+    }
+
+    std::unordered_map<std::string, int> ids;
+    std::vector<int> a, b;
+    std::vector<int> inA, inB;
+
+    auto intern = [&](const std::string &line)
+    {
+        auto it = ids.emplace(line, static_cast<int>(ids.size())).first;
+        if (static_cast<std::size_t>(it->second) >= inA.size())
+        {
+            inA.push_back(0);
+            inB.push_back(0);
+        }
+        return it->second;
+    };
+
+    for (std::size_t i = begin; i < endA; i++)
+        a.push_back(intern(A[i]));
+    for (std::size_t i = begin; i < endB; i++)
+        b.push_back(intern(B[i]));
+    for (int id : a)
+        inA[id]++;
+    for (int id : b)
+        inB[id]++;
+
+    deletions = insertions = 0;
+    std::vector<int> x, y;
+    for (int id : a)
+    {
+        if (inB[id])
+            x.push_back(id);
+        else
+            deletions++;
+    }
+    for (int id : b)
+    {
+        if (inA[id])
+            y.push_back(id);
+        else
+            insertions++;
+    }
+
+    int n = x.size(), m = y.size(), max = n + m;
+    std::vector<int> v(2 * max + 3);
+    int offset = max + 1;
+
+    for (int d = 0; d <= max; d++)
+    {
+        for (int k = -d; k <= d; k += 2)
+        {
+            int i = (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1]))
+                        ? v[offset + k + 1]
+                        : v[offset + k - 1] + 1;
+            int j = i - k;
+            while (i < n && j < m && x[i] == y[j])
+            {
+                i++;
+                j++;
+            }
+            v[offset + k] = i;
+
+            if (i >= n && j >= m)
+            {
+                int common = (n + m - d) / 2;
+                deletions += n - common;
+                insertions += m - common;
+                return;
+            }
+        }
+    }
+}
+
+static void printStat(const std::vector<Change> &changes,
+                      const std::unordered_map<std::string, fs::path> &filesA,
+                      const std::unordered_map<std::string, fs::path> &filesB,
+                      ManifestMap &manifestA, ManifestMap &manifestB)
+{
+    const std::size_t BAR_WIDTH = 50;
+
+    struct Row
+    {
+        std::string name, detail;
+        std::size_t ins, del;
+        bool binary;
+    };
+    std::vector<Row> rows;
+    std::size_t totalIns = 0, totalDel = 0, widest = 0, biggest = 0;
+
+    for (auto &c : changes)
+    {
+        Row r{c.status == 'R' || c.status == 'C' ? c.from + " => " + c.to : c.to, "", 0, 0, false};
+        bool hasA = c.status != 'A', hasB = c.status != 'D';
+
+        r.binary = (hasA && Binary::isBinary(c.from, filesA.at(c.from).string())) ||
+                   (hasB && Binary::isBinary(c.to, filesB.at(c.to).string()));
+
+        if (r.binary)
+        {
+            r.detail = "Bin " + std::to_string(hasA ? manifestA[c.from].size : 0) + " -> " +
+                       std::to_string(hasB ? manifestB[c.to].size : 0) + " bytes";
+        }
+        else
+        {
+            static const std::vector<std::string> none;
+            auto linesA = hasA ? ObjectCache::lines(filesA.at(c.from).string()) : nullptr;
+            auto linesB = hasB ? ObjectCache::lines(filesB.at(c.to).string()) : nullptr;
+
+            countLines(linesA ? *linesA : none, linesB ? *linesB : none, r.ins, r.del);
+            totalIns += r.ins;
+            totalDel += r.del;
+            biggest = std::max(biggest, r.ins + r.del);
+        }
+
+        widest = std::max(widest, r.name.size());
+        rows.push_back(r);
+    }
+
+    for (auto &r : rows)
+    {
+        std::cout << " " << r.name << std::string(widest - r.name.size(), ' ') << " | ";
+
+        if (r.binary)
+        {
+            std::cout << r.detail << "\n";
+            continue;
+        }
+
+        std::size_t plus = r.ins, minus = r.del;
+        if (biggest > BAR_WIDTH)
+        {
+            plus = r.ins ? std::max<std::size_t>(1, r.ins * BAR_WIDTH / biggest) : 0;
+            minus = r.del ? std::max<std::size_t>(1, r.del * BAR_WIDTH / biggest) : 0;
+        }
+        std::cout << r.ins + r.del << (plus + minus ? " " : "") << std::string(plus, '+')
+                  << std::string(minus, '-') << "\n";
+    }
+
+    std::cout << " " << rows.size() << (rows.size() == 1 ? " file" : " files") << " changed, "
+              << totalIns << (totalIns == 1 ? " insertion(+), " : " insertions(+), ")
+              << totalDel << (totalDel == 1 ? " deletion(-)" : " deletions(-)") << "\n";
+}
+
+/*
+ * @brief --name-only / --name-status / --stat.
+ *
+ * Which paths changed is decided from the two manifests alone;
+ * renames are paired by exact hash only, except for --stat, which
+ * opens the changed files anyway and so also runs the similarity step.
+ */
+static void showSummary(const std::string &A, const std::string &B, const DiffOptions &opts)
+{
+    auto manifestA = Manifest::load(A);
+    auto manifestB = Manifest::load(B);
+    auto filesA = buildFileMap(A, manifestA);
+    auto filesB = buildFileMap(B, manifestB);
+
+    bool stat = opts.format == DiffFormat::Stat;
+    auto pairings = detectRenames(filesA, filesB, manifestA, manifestB, opts, stat);
+
+    std::unordered_set<std::string> renamedFrom, pairedTo;
+    for (auto &p : pairings)
+    {
+        if (!p.copy)
+            renamedFrom.insert(p.from);
+        pairedTo.insert(p.to);
+    }
+
+    std::vector<Change> changes;
+    for (auto &[path, a] : manifestA)
+    {
+        auto it = manifestB.find(path);
+        if (it == manifestB.end())
+        {
+            if (!renamedFrom.count(path))
+                changes.push_back({'D', path, path, 0});
+        }
+        else if (it->second.hash != a.hash || it->second.size != a.size)
+            changes.push_back({'M', path, path, 0});
+    }
+    for (auto &[path, b] : manifestB)
+    {
+        if (!manifestA.count(path) && !pairedTo.count(path))
+            changes.push_back({'A', path, path, 0});
+    }
+    for (auto &p : pairings)
+        changes.push_back({p.copy ? 'C' : 'R', p.from, p.to, p.score});
+
+    std::sort(changes.begin(), changes.end(), [](const Change &x, const Change &y)
+    {
+        return x.to != y.to ? x.to < y.to : x.from < y.from;
+    });
+
+    if (stat)
+    {
+        printStat(changes, filesA, filesB, manifestA, manifestB);
+        return;
+    }
+
+    for (auto &c : changes)
+    {
+        if (opts.format == DiffFormat::NameOnly)
+            std::cout << c.to << "\n";
+        else if (c.status == 'R' || c.status == 'C')
+            std::cout << c.status << c.score << "\t" << c.from << "\t" << c.to << "\n";
+        else
+            std::cout << c.status << "\t" << c.to << "\n";
+    }
+}
+
+/*
+ * @brief Renames and copies between two commits, as diff reports them.
+ *
+ * @return Pairings in detection order: exact matches first, then
+ *         verified similar files.
+ */
+std::vector<Pairing> Diff::renames(const std::string &A, const std::string &B, const DiffOptions &opts)
+{
+    auto manifestA = Manifest::load(A);
+    auto manifestB = Manifest::load(B);
+    auto filesA = buildFileMap(A, manifestA);
+    auto filesB = buildFileMap(B, manifestB);
+
+    return detectRenames(filesA, filesB, manifestA, manifestB, opts);
+}
+
+int Diff::show(const std::string &A,
+               const std::string &B,
+               const DiffOptions &opts)
+{
+    // A missing commit would load as an empty manifest and show every
+    // file of the other side as added or deleted.
+    for (auto &commit : {A, B})
+    {
+        if (commit.empty() || !fs::is_directory(Repository::objectDir(commit)))
+        {
+            std::cout << "Unknown commit '" << commit << "'.\n";
+            return 1;
+        }
+    }
+
+    if (opts.format != DiffFormat::Patch)
+    {
+        showSummary(A, B, opts);
+        return 0;
+    }
+
+    auto manifestA = Manifest::load(A);
+    auto manifestB = Manifest::load(B);
+    auto filesA = buildFileMap(A, manifestA);
+    auto filesB = buildFileMap(B, manifestB);
+
+    auto pairings = detectRenames(filesA, filesB, manifestA, manifestB, opts);
+
+    std::unordered_set<std::string> renamedFrom, pairedTo;
+    for (auto &p : pairings)
+    {
+        if (!p.copy)
+            renamedFrom.insert(p.from);
+        pairedTo.insert(p.to);
+    }
+
+    std::unordered_map<std::string, bool> visited;
+
+    for (auto &[path, fileA] : filesA)
+    {
+        visited[path] = true;
+
+        if (!filesB.count(path))
+        {
+            if (!renamedFrom.count(path))
+                std::cout << "Deleted: " << path << "\n";
+        }
+        else
+        {
+            printFileDiff(path, fileA, manifestA[path], path, filesB[path], manifestB[path], opts);
+        }
+    }
+
     for (auto &[path, fileB] : filesB)
     {
-        if (!visited[path])
+        if (!visited[path] && !pairedTo.count(path))
         {
             std::cout << "Added: " << path << "\n";
         }
     }
+
+    for (auto &p : pairings)
+    {
+        std::cout << (p.copy ? "copied: " : "renamed: ") << p.from << " -> " << p.to
+                  << " (" << p.score << "%)\n";
+        printFileDiff(p.from, filesA[p.from], manifestA[p.from], p.to, filesB[p.to], manifestB[p.to], opts);
+    }
+
+    return 0;
 }
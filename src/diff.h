@@ -1,13 +1,45 @@
 #ifndef DIFF_H
 #define DIFF_H
 
+#include <cstddef>
 #include <string>
+#include <vector>
+
+enum class DiffFormat
+{
+    Patch,      // line-by-line diff (default)
+    NameOnly,   // changed paths, from manifests only
+    NameStatus, // A/D/M/R<score>/C<score> + paths, from manifests only
+    Stat        // per-file insertion/deletion counts
+};
+
+struct DiffOptions
+{
+    bool renames = true;            // pair deleted/added files by content
+    bool copies = false;            // also pair added files with unchanged ones
+    std::size_t renameLimit = 1000; // max similar-content candidate pairs verified
+    bool delta = false;             // summarize binary changes as a byte-level delta
+    DiffFormat format = DiffFormat::Patch;
+};
+
+// A file of commitB paired with the commitA file it came from.
+struct Pairing
+{
+    std::string from, to;
+    int score; // similarity in percent, 100 for identical content
+    bool copy; // from still exists in commitB
+};
 
 class Diff
 {
 public:
-    static void show(const std::string &commitA,
-                     const std::string &commitB);
+    static std::vector<Pairing> renames(const std::string &commitA,
+                                        const std::string &commitB,
+                                        const DiffOptions &opts = DiffOptions());
+    // @return 1 if either commit does not exist.
+    static int show(const std::string &commitA,
+                    const std::string &commitB,
+                    const DiffOptions &opts = DiffOptions());
 };
 
 #endif
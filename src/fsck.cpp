@@ -0,0 +1,386 @@
+#include "fsck.h"
+#include "manifest.h"
+#include "objectcache.h"
+#include "repository.h"
+#include "repostate.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct HashTask
+{
+    fs::path file;
+    std::string where; // "<commit>:<path>" for messages
+    std::string expected;
+    std::uintmax_t size;
+};
+
+static std::mutex problemLock;
+static std::vector<std::string> problems;
+
+static void report(const std::string &problem)
+{
+    std::lock_guard<std::mutex> guard(problemLock);
+    problems.push_back(problem);
+}
+
+static bool commitExists(const std::string &commit)
+{
+    return fs::is_directory(Repository::objectDir(commit));
+}
+
+/*
+ * @brief Validate a meta file as written by Commit::create.
+ *
+ * ObjectCache::meta is lenient so that normal commands survive damage;
+ * fsck reads the file itself to report it.
+ *
+ * @return What is wrong, or an empty string if the meta is well formed.
+ */
+static std::string metaProblem(const std::string &commit, const fs::path &metaPath)
+{
+    std::ifstream in(metaPath);
+    std::string line;
+    bool sawCommit = false, sawParent = false;
+
+    while (std::getline(in, line))
+    {
+        if (line.rfind("commit ", 0) == 0)
+        {
+            if (line.substr(7) != commit)
+                return "names commit " + line.substr(7);
+            sawCommit = true;
+        }
+        else if (line.rfind("parent ", 0) == 0)
+            sawParent = true;
+        else if (line.rfind("generation ", 0) == 0)
+        {
+            std::string digits = line.substr(11);
+            bool ok = !digits.empty() && digits.size() <= 9;
+            for (char c : digits)
+                ok = ok && std::isdigit(static_cast<unsigned char>(c));
+            if (!ok)
+                return "bad generation '" + digits + "'";
+        }
+    }
+
+    if (!sawCommit)
+        return "no commit line";
+    if (!sawParent)
+        return "no parent line";
+    return "";
+}
+
+/*
+ * @brief Check one commit's metadata and collect its files for hashing.
+ *
+ * Reads the manifest file directly so a missing or old-style one is
+ * checked as it is rather than regenerated.
+ */
+static void checkCommit(const std::string &commit, std::vector<HashTask> &tasks)
+{
+    fs::path commitPath = ".mygit/objects/" + commit;
+    fs::path filesPath = commitPath / "files";
+
+    // A damaged meta is one finding for this commit, never the end of the run.
+    try
+    {
+        auto meta = ObjectCache::meta(commit);
+        if (!meta)
+            report("commit " + commit + ": missing meta");
+        else
+        {
+            std::string problem = metaProblem(commit, commitPath / "meta");
+            if (!problem.empty())
+                report("commit " + commit + ": corrupt meta (" + problem + ")");
+
+            for (auto &p : meta->parents)
+                if (!commitExists(p))
+                    report("commit " + commit + ": parent " + p + " does not exist");
+        }
+    }
+    catch (const std::exception &e)
+    {
+        report("commit " + commit + ": corrupt meta (" + e.what() + ")");
+    }
+
+    bool hasManifest = fs::exists(commitPath / "manifest");
+    if (!hasManifest)
+        report("commit " + commit + ": missing manifest");
+
+    auto entries = Manifest::read(commit);
+
+    if (fs::exists(filesPath))
+    {
+        for (auto &entry : fs::recursive_directory_iterator(filesPath))
+        {
+            if (!entry.is_regular_file())
+                continue;
+
+            std::string rel = fs::relative(entry.path(), filesPath).generic_string();
+            auto it = entries.find(rel);
+
+            if (it == entries.end())
+            {
+                if (hasManifest)
+                    report("commit " + commit + ": " + rel + " not in manifest");
+                continue;
+            }
+
+            tasks.push_back({entry.path(), commit + ":" + rel, it->second.hash, it->second.size});
+            entries.erase(it);
+        }
+    }
+
+    for (auto &[path, e] : entries)
+        report("commit " + commit + ": " + path + " missing from snapshot");
+}
+
+static void checkRefs()
+{
+    for (auto &entry : fs::directory_iterator(".mygit/branches"))
+    {
+        std::string name = entry.path().filename().string();
+        std::string commit = RepoState::firstLine(entry.path().string());
+
+        if (!commit.empty() && commit != "NONE" && !commitExists(commit))
+            report("branch " + name + ": points to missing commit " + commit);
+    }
+
+    auto alternates = RepoState::lines(".mygit/objects/alternates");
+    for (auto &alt : *alternates)
+    {
+        if (!alt.empty() && !fs::is_directory(alt))
+            report("alternates: object store " + alt + " does not exist");
+    }
+
+    std::string mergeHead = RepoState::firstLine(".mygit/MERGE_HEAD");
+    if (!mergeHead.empty() && !commitExists(mergeHead))
+        report("MERGE_HEAD: points to missing commit " + mergeHead);
+}
+
+/*
+ * @brief Check the index against the object store.
+ *
+ * Entries must be unique, normalized paths inside the working tree
+ * that exist. The commit they will be committed on top of (HEAD) must
+ * be readable, and each staged path it already tracks must be in its
+ * snapshot with the manifest's hash. Local commits are hashed by the
+ * object scan anyway; a HEAD found through alternates is not, so its
+ * staged entries are queued here.
+ */
+static void checkIndex(std::vector<HashTask> &tasks)
+{
+    std::string ref = RepoState::firstLine(".mygit/HEAD");
+    std::string head = RepoState::firstLine(".mygit/branches/" + ref.substr(ref.find_last_of('/') + 1));
+    bool hasHead = !head.empty() && head != "NONE" && commitExists(head);
+    bool local = hasHead && fs::is_directory(".mygit/objects/" + head);
+
+    std::map<std::string, ManifestEntry> manifest;
+    if (hasHead)
+    {
+        if (!fs::exists(Repository::objectDir(head) + "/manifest"))
+            report("index: HEAD commit " + head + " has no manifest");
+        manifest = Manifest::read(head);
+    }
+
+    auto index = RepoState::lines(".mygit/index");
+    std::set<std::string> seen;
+
+    for (auto &path : *index)
+    {
+        if (path.empty())
+            continue;
+
+        fs::path p(path);
+        std::string first = p.begin() == p.end() ? "" : p.begin()->string();
+
+        if (!seen.insert(path).second)
+        {
+            report("index: " + path + " is staged twice");
+            continue;
+        }
+
+        if (p.is_absolute() || p.lexically_normal().generic_string() != path ||
+            first == ".." || first == ".mygit")
+        {
+            report("index: " + path + " is not a normalized path inside the working tree");
+            continue;
+        }
+
+        if (!fs::is_regular_file(path))
+            report("index: staged file " + path + " does not exist");
+
+        auto it = manifest.find(path);
+        if (it == manifest.end())
+            continue;
+
+        fs::path stored = fs::path(Repository::objectDir(head)) / "files" / path;
+        if (!fs::is_regular_file(stored))
+            report("index: " + path + " is tracked by HEAD " + head + " but missing from its snapshot");
+        else if (!local)
+            tasks.push_back({stored, head + ":" + path + " (index base)", it->second.hash, it->second.size});
+    }
+}
+
+static void printProgress(std::size_t files, std::size_t total, std::uint64_t bytes, double seconds)
+{
+    double mb = bytes / 1048576.0;
+    std::cerr << "\rChecking objects: " << files << "/" << total << " files, "
+              << std::fixed << std::setprecision(1) << mb << " MiB, "
+              << (seconds > 0 ? mb / seconds : 0.0) << " MiB/s   " << std::flush;
+}
+
+int Fsck::run(unsigned threads)
+{
+    if (!Repository::exists())
+    {
+        std::cout << "Not a mygit repository.\n";
+        return 1;
+    }
+
+    problems.clear();
+
+    std::vector<HashTask> tasks;
+    for (auto &entry : fs::directory_iterator(".mygit/objects"))
+    {
+        if (entry.is_directory())
+            checkCommit(entry.path().filename().string(), tasks);
+    }
+
+    checkRefs();
+    checkIndex(tasks);
+
+    // Biggest files first, so one huge file does not finish last on a single thread.
+    std::sort(tasks.begin(), tasks.end(), [](const HashTask &a, const HashTask &b)
+    {
+        return a.size > b.size;
+    });
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Files up to 64 KiB sit at the end after sorting; they are claimed
+    // eight at a time and hashed together by the multi-buffer kernel.
+    const std::uintmax_t SMALL_FILE = 64 * 1024;
+    const std::size_t BATCH = 8;
+    std::size_t firstSmall = std::find_if(tasks.begin(), tasks.end(), [&](const HashTask &t)
+    {
+        return t.size <= SMALL_FILE;
+    }) - tasks.begin();
+
+    std::atomic<std::size_t> nextLarge{0}, nextSmall{firstSmall}, done{0};
+    std::atomic<std::uint64_t> bytes{0};
+    auto start = std::chrono::steady_clock::now();
+
+    // Returns true if the file still has to be hashed.
+    auto checkSize = [&](const HashTask &t)
+    {
+        std::error_code ec;
+        auto size = fs::file_size(t.file, ec);
+
+        if (ec)
+            report(t.where + ": unreadable");
+        else if (size != t.size)
+            report(t.where + ": size " + std::to_string(size) + ", manifest says " + std::to_string(t.size));
+
+        bytes += ec ? 0 : size;
+        return !ec && size == t.size;
+    };
+
+    auto checkOne = [&](const HashTask &t)
+    {
+        bool legacy = t.expected.size() == 16;
+        if (checkSize(t) && Manifest::hashFile(t.file.string(), legacy) != t.expected)
+            report(t.where + ": content hash mismatch");
+        done++;
+    };
+
+    auto worker = [&]()
+    {
+        std::size_t i;
+        while ((i = nextLarge++) < firstSmall)
+            checkOne(tasks[i]);
+
+        while ((i = nextSmall.fetch_add(BATCH)) < tasks.size())
+        {
+            std::size_t end = std::min(i + BATCH, tasks.size());
+            std::vector<const HashTask *> batch;
+            std::vector<std::string> paths;
+
+            for (; i < end; i++)
+            {
+                if (tasks[i].expected.size() == 16)
+                    checkOne(tasks[i]);
+                else if (checkSize(tasks[i]))
+                {
+                    batch.push_back(&tasks[i]);
+                    paths.push_back(tasks[i].file.string());
+                }
+                else
+                    done++;
+            }
+
+            auto hashes = Manifest::hashFiles(paths);
+            for (std::size_t k = 0; k < batch.size(); k++)
+            {
+                if (hashes[k] != batch[k]->expected)
+                    report(batch[k]->where + ": content hash mismatch");
+                done++;
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 0; i < threads; i++)
+        pool.emplace_back(worker);
+
+    auto elapsed = [&]()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    double lastPrint = 0;
+    while (done < tasks.size())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        if (elapsed() - lastPrint >= 0.5)
+        {
+            lastPrint = elapsed();
+            printProgress(done, tasks.size(), bytes, lastPrint);
+        }
+    }
+
+    for (auto &t : pool)
+        t.join();
+
+    printProgress(done, tasks.size(), bytes, elapsed());
+    std::cerr << "(" << threads << " threads)\n";
+
+    std::sort(problems.begin(), problems.end());
+    for (auto &p : problems)
+        std::cout << p << "\n";
+
+    if (problems.empty())
+    {
+        std::cout << "No problems found.\n";
+        return 0;
+    }
+
+    std::cout << problems.size() << " problem(s) found.\n";
+    return 1;
+}
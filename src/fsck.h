@@ -0,0 +1,27 @@
+/*
+fsck = read-only integrity check of the repository.
+    objects  : every commit has meta + manifest, every snapshot file
+               hashes to its manifest entry, no files missing/extra
+    commits  : every parent / parent2 points to an existing commit
+    branches : every branch file is empty or names an existing commit
+    index    : entries are unique, normalized working-tree paths that
+               exist; HEAD's commit is readable and every staged path
+               it tracks is in its snapshot with the manifest's hash
+               (hashed here if HEAD lives in an alternate store);
+               MERGE_HEAD names a commit
+    alternates: every listed object store exists (its commits are
+               checked by fsck in that repository)
+File hashing runs on a thread pool (one streaming reader per thread;
+small files go through the multi-buffer SHA-256 eight at a time),
+with progress and throughput reported on stderr.
+*/
+#ifndef FSCK_H
+#define FSCK_H
+
+class Fsck
+{
+public:
+    static int run(unsigned threads);
+};
+
+#endif
@@ -0,0 +1,752 @@
+#include "hash.h"
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define MYGIT_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+static const std::uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static const std::uint32_t H0[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+static std::uint32_t loadBE32(const unsigned char *p)
+{
+    return (std::uint32_t)p[0] << 24 | (std::uint32_t)p[1] << 16 | (std::uint32_t)p[2] << 8 | p[3];
+}
+
+static void storeBE32(unsigned char *p, std::uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static std::uint32_t rotr(std::uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+// ---- single-buffer kernels: compress `blocks` consecutive 64-byte blocks ----
+
+using CompressFn = void (*)(std::uint32_t state[8], const unsigned char *data, std::size_t blocks);
+
+static void compressPortable(std::uint32_t state[8], const unsigned char *data, std::size_t blocks)
+{
+    std::uint32_t w[64];
+
+    while (blocks--)
+    {
+        for (int t = 0; t < 16; t++)
+            w[t] = loadBE32(data + 4 * t);
+        for (int t = 16; t < 64; t++)
+        {
+            std::uint32_t s0 = rotr(w[t - 15], 7) ^ rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+            std::uint32_t s1 = rotr(w[t - 2], 17) ^ rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+
+        std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        std::uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int t = 0; t < 64; t++)
+        {
+            std::uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[t] + w[t];
+            std::uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+
+        data += 64;
+    }
+}
+
+#ifdef MYGIT_X86_KERNELS
+/*
+ * SHA-NI kernel. State is kept as ABEF/CDGH as the sha256rnds2
+ * instruction expects; each loop step does 4 rounds, with msg1/msg2
+ * computing the next message words in the same pass.
+ */
+__attribute__((target("sha,sse4.1")))
+static void compressShaNi(std::uint32_t state[8], const unsigned char *data, std::size_t blocks)
+{
+    const __m128i MASK = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&state[0]));
+    __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&state[4]));
+
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);                // CDAB
+    state1 = _mm_shuffle_epi32(state1, 0x1B);          // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);  // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);       // CDGH
+
+    while (blocks--)
+    {
+        __m128i abefSave = state0, cdghSave = state1;
+        __m128i m[4];
+
+        for (int g = 0; g < 16; g++)
+        {
+            if (g < 4)
+                m[g] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16 * g)), MASK);
+
+            __m128i msg = _mm_add_epi32(m[g % 4], _mm_loadu_si128(reinterpret_cast<const __m128i *>(&K[4 * g])));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+
+            if (g >= 3 && g <= 14)
+            {
+                __m128i t = _mm_alignr_epi8(m[g % 4], m[(g + 3) % 4], 4);
+                m[(g + 1) % 4] = _mm_add_epi32(m[(g + 1) % 4], t);
+                m[(g + 1) % 4] = _mm_sha256msg2_epu32(m[(g + 1) % 4], m[g % 4]);
+            }
+
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+            if (g >= 1 && g <= 12)
+                m[(g + 3) % 4] = _mm_sha256msg1_epu32(m[(g + 3) % 4], m[g % 4]);
+        }
+
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+        data += 64;
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);         // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);      // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);   // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);      // ABEF
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(&state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(&state[4]), state1);
+}
+
+#define AVX2_FN __attribute__((target("avx2")))
+
+AVX2_FN static inline __m256i rotr8(__m256i x, int n)
+{
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+/*
+ * AVX2 multi-buffer kernel: hashes up to 8 independent messages at once,
+ * one per 32-bit lane. Messages may differ in length; a lane whose
+ * message has run out keeps its state via a blend mask.
+ */
+AVX2_FN static void sha256x8(const unsigned char *const *data, const std::size_t *len,
+                             std::size_t n, Digest *out)
+{
+    alignas(32) unsigned char tail[8][128] = {};
+    std::size_t full[8] = {}, blocks[8] = {}, maxBlocks = 0;
+
+    for (std::size_t i = 0; i < n; i++)
+    {
+        full[i] = len[i] / 64;
+        std::size_t rem = len[i] % 64;
+        std::memcpy(tail[i], data[i] + full[i] * 64, rem);
+        tail[i][rem] = 0x80;
+
+        std::size_t tailBlocks = rem < 56 ? 1 : 2;
+        std::uint64_t bits = static_cast<std::uint64_t>(len[i]) * 8;
+        storeBE32(tail[i] + tailBlocks * 64 - 8, static_cast<std::uint32_t>(bits >> 32));
+        storeBE32(tail[i] + tailBlocks * 64 - 4, static_cast<std::uint32_t>(bits));
+
+        blocks[i] = full[i] + tailBlocks;
+        if (blocks[i] > maxBlocks)
+            maxBlocks = blocks[i];
+    }
+
+    __m256i s[8];
+    for (int k = 0; k < 8; k++)
+        s[k] = _mm256_set1_epi32(H0[k]);
+
+    for (std::size_t b = 0; b < maxBlocks; b++)
+    {
+        const unsigned char *p[8];
+        alignas(32) std::int32_t active[8];
+
+        for (int i = 0; i < 8; i++)
+        {
+            active[i] = b < blocks[i] ? -1 : 0;
+            if (b < full[i])
+                p[i] = data[i] + 64 * b;
+            else if (b < blocks[i])
+                p[i] = tail[i] + 64 * (b - full[i]);
+            else
+                p[i] = tail[i];
+        }
+
+        __m256i mask = _mm256_load_si256(reinterpret_cast<const __m256i *>(active));
+        __m256i w[64];
+
+        for (int t = 0; t < 16; t++)
+        {
+            w[t] = _mm256_set_epi32(loadBE32(p[7] + 4 * t), loadBE32(p[6] + 4 * t),
+                                    loadBE32(p[5] + 4 * t), loadBE32(p[4] + 4 * t),
+                                    loadBE32(p[3] + 4 * t), loadBE32(p[2] + 4 * t),
+                                    loadBE32(p[1] + 4 * t), loadBE32(p[0] + 4 * t));
+        }
+        for (int t = 16; t < 64; t++)
+        {
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr8(w[t - 15], 7), rotr8(w[t - 15], 18)),
+                                          _mm256_srli_epi32(w[t - 15], 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr8(w[t - 2], 17), rotr8(w[t - 2], 19)),
+                                          _mm256_srli_epi32(w[t - 2], 10));
+            w[t] = _mm256_add_epi32(_mm256_add_epi32(w[t - 16], s0), _mm256_add_epi32(w[t - 7], s1));
+        }
+
+        __m256i a = s[0], bb = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+
+        for (int t = 0; t < 64; t++)
+        {
+            __m256i S1 = _mm256_xor_si256(_mm256_xor_si256(rotr8(e, 6), rotr8(e, 11)), rotr8(e, 25));
+            __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+            __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, S1),
+                                          _mm256_add_epi32(ch, _mm256_add_epi32(_mm256_set1_epi32(K[t]), w[t])));
+            __m256i S0 = _mm256_xor_si256(_mm256_xor_si256(rotr8(a, 2), rotr8(a, 13)), rotr8(a, 22));
+            __m256i maj = _mm256_xor_si256(_mm256_xor_si256(_mm256_and_si256(a, bb), _mm256_and_si256(a, c)),
+                                           _mm256_and_si256(bb, c));
+            __m256i t2 = _mm256_add_epi32(S0, maj);
+            h = g;
+            g = f;
+            f = e;
+            e = _mm256_add_epi32(d, t1);
+            d = c;
+            c = bb;
+            bb = a;
+            a = _mm256_add_epi32(t1, t2);
+        }
+
+        __m256i next[8] = {a, bb, c, d, e, f, g, h};
+        for (int k = 0; k < 8; k++)
+            s[k] = _mm256_blendv_epi8(s[k], _mm256_add_epi32(s[k], next[k]), mask);
+    }
+
+    alignas(32) std::uint32_t words[8][8];
+    for (int k = 0; k < 8; k++)
+        _mm256_store_si256(reinterpret_cast<__m256i *>(words[k]), s[k]);
+
+    for (std::size_t i = 0; i < n; i++)
+        for (int k = 0; k < 8; k++)
+            storeBE32(out[i].data() + 4 * k, words[k][i]);
+}
+#endif
+
+// ---- kernel selection ----
+
+static CompressFn singleKernel = compressPortable;
+static const char *singleName = "portable";
+static bool multiAvx2 = false;
+
+static bool cpuHasShaNi()
+{
+#ifdef MYGIT_X86_KERNELS
+    return __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+#else
+    return false;
+#endif
+}
+
+static bool cpuHasAvx2()
+{
+#ifdef MYGIT_X86_KERNELS
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+static bool applyKernel(const std::string &name);
+
+// Default kernels for this CPU (or MYGIT_HASH_KERNEL).
+static void detect()
+{
+    singleKernel = compressPortable;
+    singleName = "portable";
+    multiAvx2 = false;
+
+    const char *forced = std::getenv("MYGIT_HASH_KERNEL");
+    if (forced && applyKernel(forced))
+        return;
+
+#ifdef MYGIT_X86_KERNELS
+    if (cpuHasShaNi())
+    {
+        singleKernel = compressShaNi;
+        singleName = "sha-ni";
+    }
+    multiAvx2 = cpuHasAvx2();
+#endif
+}
+
+// Hashing starts on several fsck threads at once; the first one detects.
+static std::once_flag detectOnce;
+
+static void select()
+{
+    std::call_once(detectOnce, detect);
+}
+
+std::vector<std::string> Hash::kernels()
+{
+    std::vector<std::string> names{"portable"};
+    if (cpuHasShaNi())
+        names.push_back("sha-ni");
+    if (cpuHasAvx2())
+        names.push_back("avx2");
+    return names;
+}
+
+/*
+ * @brief Force a kernel.
+ *
+ * "portable" and "sha-ni" pick the single-buffer kernel and turn the
+ * multi-buffer path off; "avx2" turns the multi-buffer path on and
+ * leaves the single-buffer kernel as it is.
+ *
+ * Meant for self-test and benchmark runs: must not be called while
+ * other threads are hashing.
+ *
+ * @return false if the name is unknown or the CPU lacks support.
+ */
+bool Hash::useKernel(const std::string &name)
+{
+    select();
+    return applyKernel(name);
+}
+
+static bool applyKernel(const std::string &name)
+{
+    if (name == "portable")
+    {
+        singleKernel = compressPortable;
+        singleName = "portable";
+        multiAvx2 = false;
+        return true;
+    }
+#ifdef MYGIT_X86_KERNELS
+    if (name == "sha-ni" && cpuHasShaNi())
+    {
+        singleKernel = compressShaNi;
+        singleName = "sha-ni";
+        multiAvx2 = false;
+        return true;
+    }
+    if (name == "avx2" && cpuHasAvx2())
+    {
+        multiAvx2 = true;
+        return true;
+    }
+#endif
+    return false;
+}
+
+std::string Hash::kernel()
+{
+    select();
+    return std::string(singleName) + (multiAvx2 ? " + avx2 x8" : "");
+}
+
+// ---- SHA-256 front ends ----
+
+Sha256::Sha256() : bufLen_(0), total_(0)
+{
+    select();
+    std::memcpy(state_, H0, sizeof(state_));
+}
+
+void Sha256::update(const void *data, std::size_t len)
+{
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    total_ += len;
+
+    if (bufLen_)
+    {
+        std::size_t take = std::min(len, 64 - bufLen_);
+        std::memcpy(buf_ + bufLen_, p, take);
+        bufLen_ += take;
+        p += take;
+        len -= take;
+
+        if (bufLen_ < 64)
+            return;
+        singleKernel(state_, buf_, 1);
+        bufLen_ = 0;
+    }
+
+    if (len >= 64)
+    {
+        singleKernel(state_, p, len / 64);
+        p += len / 64 * 64;
+        len %= 64;
+    }
+
+    std::memcpy(buf_, p, len);
+    bufLen_ = len;
+}
+
+Digest Sha256::finish()
+{
+    std::uint64_t bits = total_ * 8;
+    unsigned char pad[72] = {0x80};
+    std::size_t padLen = (bufLen_ < 56 ? 56 : 120) - bufLen_;
+
+    for (int i = 0; i < 8; i++)
+        pad[padLen + i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+
+    update(pad, padLen + 8);
+
+    Digest d;
+    for (int k = 0; k < 8; k++)
+        storeBE32(d.data() + 4 * k, state_[k]);
+    return d;
+}
+
+Digest Hash::sha256(const void *data, std::size_t len)
+{
+    Sha256 ctx;
+    ctx.update(data, len);
+    return ctx.finish();
+}
+
+/*
+ * @brief Hash n independent messages.
+ *
+ * Uses the AVX2 kernel eight messages at a time when available;
+ * otherwise hashes them one after another.
+ */
+void Hash::sha256Many(const unsigned char *const *data, const std::size_t *len,
+                      std::size_t n, Digest *out)
+{
+    select();
+
+#ifdef MYGIT_X86_KERNELS
+    if (multiAvx2)
+    {
+        for (std::size_t i = 0; i < n; i += 8)
+            sha256x8(data + i, len + i, std::min<std::size_t>(8, n - i), out + i);
+        return;
+    }
+#endif
+
+    for (std::size_t i = 0; i < n; i++)
+        out[i] = sha256(data[i], len[i]);
+}
+
+std::string Hash::hex(const Digest &d)
+{
+    std::ostringstream out;
+    for (unsigned char c : d)
+        out << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(c);
+    return out.str();
+}
+
+// ---- fast64: XXH64 ----
+
+static const std::uint64_t P1 = 11400714785074694791ULL;
+static const std::uint64_t P2 = 14029467366897019727ULL;
+static const std::uint64_t P3 = 1609587929392839161ULL;
+static const std::uint64_t P4 = 9650029242287828579ULL;
+static const std::uint64_t P5 = 2870177450012600261ULL;
+
+static std::uint64_t rotl64(std::uint64_t x, int n)
+{
+    return (x << n) | (x >> (64 - n));
+}
+
+static std::uint64_t loadLE64(const unsigned char *p)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+#else
+    std::uint64_t v = 0;
+    for (int i = 7; i >= 0; i--)
+        v = v << 8 | p[i];
+    return v;
+#endif
+}
+
+static std::uint64_t loadLE32(const unsigned char *p)
+{
+    return (std::uint64_t)p[0] | (std::uint64_t)p[1] << 8 | (std::uint64_t)p[2] << 16 | (std::uint64_t)p[3] << 24;
+}
+
+static std::uint64_t xxRound(std::uint64_t acc, std::uint64_t input)
+{
+    acc += input * P2;
+    acc = rotl64(acc, 31);
+    return acc * P1;
+}
+
+static std::uint64_t xxMerge(std::uint64_t acc, std::uint64_t val)
+{
+    acc ^= xxRound(0, val);
+    return acc * P1 + P4;
+}
+
+std::uint64_t Hash::fast64(const void *data, std::size_t len, std::uint64_t seed)
+{
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    const unsigned char *end = p + len;
+    std::uint64_t h;
+
+    if (len >= 32)
+    {
+        std::uint64_t v1 = seed + P1 + P2, v2 = seed + P2, v3 = seed, v4 = seed - P1;
+        const unsigned char *limit = end - 32;
+
+        do
+        {
+            v1 = xxRound(v1, loadLE64(p));
+            v2 = xxRound(v2, loadLE64(p + 8));
+            v3 = xxRound(v3, loadLE64(p + 16));
+            v4 = xxRound(v4, loadLE64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxMerge(h, v1);
+        h = xxMerge(h, v2);
+        h = xxMerge(h, v3);
+        h = xxMerge(h, v4);
+    }
+    else
+    {
+        h = seed + P5;
+    }
+
+    h += len;
+
+    for (; p + 8 <= end; p += 8)
+    {
+        h ^= xxRound(0, loadLE64(p));
+        h = rotl64(h, 27) * P1 + P4;
+    }
+    if (p + 4 <= end)
+    {
+        h ^= loadLE32(p) * P1;
+        h = rotl64(h, 23) * P2 + P3;
+        p += 4;
+    }
+    for (; p < end; p++)
+    {
+        h ^= *p * P5;
+        h = rotl64(h, 11) * P1;
+    }
+
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
+
+// ---- known-answer tests and benchmark ----
+
+struct ShaVector
+{
+    std::string message;
+    std::size_t repeat;
+    const char *digest;
+};
+
+static const ShaVector SHA_VECTORS[] = {
+    {"", 1, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+    {"abc", 1, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+    {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+     "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+    {"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu", 1,
+     "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1"},
+    {"a", 1000000, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"},
+};
+
+static bool checkSha(const std::string &kernel)
+{
+    bool ok = true;
+    std::vector<std::string> messages;
+    std::vector<const unsigned char *> ptrs;
+    std::vector<std::size_t> lens;
+
+    for (auto &v : SHA_VECTORS)
+    {
+        std::string m;
+        for (std::size_t i = 0; i < v.repeat; i++)
+            m += v.message;
+        messages.push_back(m);
+
+        if (Hash::hex(Hash::sha256(m.data(), m.size())) != v.digest)
+        {
+            std::cout << "  " << kernel << ": sha256 mismatch for \"" << v.message.substr(0, 16) << "\"\n";
+            ok = false;
+        }
+    }
+
+    // Multi-buffer: every length from 0 to 200 (all padding cases), mixed in one batch
+    std::string pattern;
+    for (int i = 0; i < 200; i++)
+        pattern += static_cast<char>(i * 7 + 3);
+    for (std::size_t l = 0; l <= 200; l++)
+        messages.push_back(pattern.substr(0, l));
+
+    for (auto &m : messages)
+    {
+        ptrs.push_back(reinterpret_cast<const unsigned char *>(m.data()));
+        lens.push_back(m.size());
+    }
+
+    std::vector<Digest> many(messages.size());
+    Hash::sha256Many(ptrs.data(), lens.data(), messages.size(), many.data());
+
+    Hash::useKernel("portable");
+    for (std::size_t i = 0; i < messages.size(); i++)
+    {
+        if (many[i] != Hash::sha256(messages[i].data(), messages[i].size()))
+        {
+            std::cout << "  " << kernel << ": multi-buffer mismatch at length " << lens[i] << "\n";
+            ok = false;
+            break;
+        }
+    }
+
+    return ok;
+}
+
+static bool checkFast64()
+{
+    std::string bytes;
+    for (int r = 0; r < 4; r++)
+        for (int i = 0; i < 256; i++)
+            bytes += static_cast<char>(i);
+
+    struct
+    {
+        std::string message;
+        std::uint64_t seed, expected;
+    } vectors[] = {
+        {"", 0, 0xef46db3751d8e999ULL},
+        {"abc", 0, 0x44bc2cf5ad770999ULL},
+        {std::string(100, 'a'), 0, 0x375041e8b1decfb3ULL},
+        {"abc", 1, 0xbea9ca8199328908ULL},
+        {bytes, 0x9e3779b97f4a7c15ULL, 0x22d0f4503bcda26aULL},
+    };
+
+    bool ok = true;
+    for (auto &v : vectors)
+    {
+        if (Hash::fast64(v.message.data(), v.message.size(), v.seed) != v.expected)
+        {
+            std::cout << "  fast64: mismatch for length " << v.message.size() << "\n";
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool Hash::selfTest()
+{
+    bool ok = true;
+
+    for (auto &k : kernels())
+    {
+        useKernel("portable");
+        useKernel(k);
+        bool pass = checkSha(k);
+        std::cout << (pass ? "ok    " : "FAIL  ") << "sha256 " << k << "\n";
+        ok = ok && pass;
+    }
+
+    bool pass = checkFast64();
+    std::cout << (pass ? "ok    " : "FAIL  ") << "fast64 (xxh64)\n";
+    ok = ok && pass;
+
+    detect();
+    return ok;
+}
+
+static double mibPerSecond(std::size_t bytes, std::chrono::steady_clock::time_point start)
+{
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return bytes / 1048576.0 / s;
+}
+
+void Hash::benchmark()
+{
+    const std::size_t TOTAL = 64u << 20;
+    const std::size_t SMALL = 4096;
+    std::vector<unsigned char> buf(TOTAL);
+    for (std::size_t i = 0; i < TOTAL; i++)
+        buf[i] = static_cast<unsigned char>(i * 2654435761u >> 13);
+
+    std::vector<const unsigned char *> ptrs;
+    std::vector<std::size_t> lens;
+    for (std::size_t off = 0; off < TOTAL; off += SMALL)
+    {
+        ptrs.push_back(buf.data() + off);
+        lens.push_back(SMALL);
+    }
+    std::vector<Digest> out(ptrs.size());
+
+    std::cout << std::fixed << std::setprecision(0);
+
+    for (auto &k : kernels())
+    {
+        useKernel("portable");
+        useKernel(k);
+
+        if (k != "avx2")
+        {
+            auto start = std::chrono::steady_clock::now();
+            volatile unsigned char sink = Hash::sha256(buf.data(), TOTAL)[0];
+            (void)sink;
+            std::cout << "sha256 " << std::setw(9) << k << "  1 x 64 MiB      "
+                      << std::setw(6) << mibPerSecond(TOTAL, start) << " MiB/s\n";
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        Hash::sha256Many(ptrs.data(), lens.data(), ptrs.size(), out.data());
+        std::cout << "sha256 " << std::setw(9) << k << "  16384 x 4 KiB   "
+                  << std::setw(6) << mibPerSecond(TOTAL, start) << " MiB/s\n";
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    volatile std::uint64_t sink = Hash::fast64(buf.data(), TOTAL);
+    (void)sink;
+    std::cout << "fast64    xxh64  1 x 64 MiB      " << std::setw(6) << mibPerSecond(TOTAL, start) << " MiB/s\n";
+
+    detect();
+}
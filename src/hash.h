@@ -0,0 +1,57 @@
+/*
+Hashing kernels, picked once at startup from CPUID:
+    SHA-256 single buffer : sha-ni  > portable
+    SHA-256 multi buffer  : avx2 (8 messages per pass) > single buffer loop
+    fast64                : XXH64, non-cryptographic; only for integrity
+                            checks (delta base, zstd frame checksum),
+                            never for content addressing.
+The choice is made once (std::call_once), so threads may start hashing
+concurrently. MYGIT_HASH_KERNEL=portable forces the portable kernels.
+"mygit hash --self-test" runs the known-answer tests on every kernel
+this CPU supports, "mygit hash --bench" measures their throughput.
+*/
+#ifndef HASH_H
+#define HASH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using Digest = std::array<unsigned char, 32>;
+
+// Streaming SHA-256 for large files.
+class Sha256
+{
+public:
+    Sha256();
+    void update(const void *data, std::size_t len);
+    Digest finish();
+
+private:
+    std::uint32_t state_[8];
+    unsigned char buf_[64];
+    std::size_t bufLen_;
+    std::uint64_t total_;
+};
+
+class Hash
+{
+public:
+    static Digest sha256(const void *data, std::size_t len);
+    static void sha256Many(const unsigned char *const *data, const std::size_t *len,
+                           std::size_t n, Digest *out);
+    static std::uint64_t fast64(const void *data, std::size_t len, std::uint64_t seed = 0);
+
+    static std::string hex(const Digest &d);
+
+    static std::string kernel();
+    static std::vector<std::string> kernels();
+    static bool useKernel(const std::string &name);
+
+    static bool selfTest();
+    static void benchmark();
+};
+
+#endif
@@ -10,6 +10,8 @@ void Help::show()
 
     std::cout << "Commands:\n";
     std::cout << "  init                    Initialize a new repository\n";
+    std::cout << "  clone <src> <dest>      Clone a local repository (objects hardlinked)\n";
+    std::cout << "    --shared              read objects from <src> via an alternates file\n";
     std::cout << "  add <file|dir>          Add files to staging area\n";
     std::cout << "  status                  Show staged files\n";
     std::cout << "  commit \"msg\"            Create a commit\n";
@@ -18,6 +20,28 @@ void Help::show()
     std::cout << "  branch <name>           Create a new branch\n";
     std::cout << "  checkout <name>         switching between branches\n";
     std::cout << "  diff <c1> <c2>          displays the differences between two input data sets\n";
+    std::cout << "    --no-renames          report moved files as Deleted/Added\n";
+    std::cout << "    --find-copies         also detect files copied from unchanged ones\n";
+    std::cout << "    --rename-limit=<n>    max similar-file candidate pairs to check\n";
+    std::cout << "    --delta               summarize binary changes as a byte-level delta\n";
+    std::cout << "    --name-only           only list changed paths (from manifests)\n";
+    std::cout << "    --name-status         changed paths with A/D/M/R/C status\n";
+    std::cout << "    --stat                per-file insertion/deletion counts\n";
+    std::cout << "  delta create <old> <new> <patch>  Byte-level delta (<commit>:<path> allowed)\n";
+    std::cout << "  delta apply <old> <patch> <out>   Rebuild a file from a delta\n";
+    std::cout << "  blame <path>            Show the commit that last changed each line\n";
+    std::cout << "  merge <branch>          Three-way merge <branch> into current branch\n";
+    std::cout << "  fsck [--threads=<n>]    Verify object hashes, commit links, refs and index\n";
+    std::cout << "  archive <commit|branch> Write the snapshot to stdout as a tar stream\n";
+    std::cout << "    --format=tar|tar.zst  zstd-compress on worker threads (tar.zst)\n";
+    std::cout << "  hash --self-test|--bench  Check or time the SHA-256 / fast hash kernels\n";
+    std::cout << "  materialize --bench     Time checkout I/O engines (io_uring, threads, sequential)\n";
+    std::cout << "  sparse-checkout set [--force] <dirs...>  Only check out root files and <dirs>\n";
+    std::cout << "  sparse-checkout list|disable   Show or turn off the sparse set\n";
+    std::cout << "  worktree add <dir> <b>  Check out branch <b> in another directory\n";
+    std::cout << "  worktree list           List worktrees sharing this object store\n";
+    std::cout << "  --batch                 Run commands read from stdin, one per line\n";
+    std::cout << "  --serve <socket>        Run commands sent to a Unix domain socket\n";
     std::cout << "  help                    Show this help message\n\n";
 
     std::cout << "Example:\n";
@@ -1,5 +1,7 @@
 #include "index.h"
 #include "repository.h"
+#include "repostate.h"
+#include "sparse.h"
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -26,7 +28,7 @@ static std::string normalizePath(const fs::path &p)
 /*
  * @brief Check whether a file is already staged.
  *
- * Reads the index file line by line and checks if the given file
+ * Scans the (cached) index lines and checks if the given file
  * path already exists in the staging area.
  *
  * @param file The normalized file path to check.
@@ -34,9 +36,8 @@ static std::string normalizePath(const fs::path &p)
  */
 bool Index::isStaged(const std::string &file)
 {
-    std::ifstream in(INDEX_PATH);
-    std::string line;
-    while (std::getline(in, line))
+    auto index = RepoState::lines(INDEX_PATH);
+    for (const auto &line : *index)
     {
         if (line == file)
             return true;
@@ -95,17 +96,32 @@ void Index::add(const std::vector<std::string> &paths)
 
         if (fs::is_regular_file(p))
         {
+            if (!Sparse::includes(normalizePath(p)))
+            {
+                std::cout << "Outside sparse checkout: " << input << "\n";
+                continue;
+            }
+
             stageFile(p);
             stagedNow.insert(normalizePath(p));
         }
         else if (fs::is_directory(p))
         {
-            for (const auto &entry : fs::recursive_directory_iterator(p))
+            for (auto it = fs::recursive_directory_iterator(p);
+                 it != fs::recursive_directory_iterator(); ++it)
             {
-                if (entry.is_regular_file())
+                std::string normalized = normalizePath(it->path());
+
+                // Skip .mygit and subtrees outside the sparse set without enumerating them
+                if (it->is_directory())
+                {
+                    if (normalized == ".mygit" || !Sparse::includesDir(normalized))
+                        it.disable_recursion_pending();
+                }
+                else if (it->is_regular_file() && Sparse::includes(normalized))
                 {
-                    stageFile(entry.path());
-                    stagedNow.insert(normalizePath(entry.path()));
+                    stageFile(it->path());
+                    stagedNow.insert(normalized);
                 }
             }
         }
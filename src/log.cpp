@@ -1,4 +1,6 @@
 #include "log.h"
+#include "repostate.h"
+#include "objectcache.h"
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -8,17 +10,13 @@ namespace fs = std::filesystem;
 
 static std::string getCurrentBranch()
 {
-    std::ifstream head(".mygit/HEAD");
-    std::string ref;
-    std::getline(head, ref);
+    std::string ref = RepoState::firstLine(".mygit/HEAD");
     return ref.substr(ref.find_last_of('/') + 1);
 }
 
 static std::string getBranchHeadCommit(const std::string &branch)
 {
-    std::ifstream in(".mygit/branches/" + branch);
-    std::string commit;
-    std::getline(in, commit);
+    std::string commit = RepoState::firstLine(".mygit/branches/" + branch);
     return commit;
 }
 
@@ -41,24 +39,16 @@ void Log::show()
 
     while (commitID != "NONE")
     {
-        fs::path metaPath = ".mygit/objects/" + commitID + "/meta";
-        std::ifstream meta(metaPath);
+        auto meta = ObjectCache::meta(commitID);
 
-        if (!meta.is_open())
+        if (!meta)
         {
             std::cout << "Corrupt commit: " << commitID << "\n";
             break;
         }
 
-        std::string line, parent, message;
-
-        while (std::getline(meta, line))
-        {
-            if (line.rfind("parent ", 0) == 0)
-                parent = line.substr(7);
-            else if (line.rfind("message ", 0) == 0)
-                message = line.substr(8);
-        }
+        std::string parent = meta->parents.empty() ? "NONE" : meta->parents[0];
+        const std::string &message = meta->message;
 
         std::cout << "commit " << commitID << "\n";
         std::cout << "    " << message << "\n\n";
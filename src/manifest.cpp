@@ -0,0 +1,251 @@
+#include "manifest.h"
+#include "hash.h"
+#include "repository.h"
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+// Files up to this size are read whole and hashed several at a time.
+static const std::uintmax_t SMALL_FILE = 64 * 1024;
+static const std::size_t LEGACY_HASH_LENGTH = 16;
+
+static std::string fnv1a(std::ifstream &in)
+{
+    std::uint64_t h = 14695981039346656037ULL;
+    char buf[65536];
+
+    while (in.read(buf, sizeof(buf)) || in.gcount() > 0)
+    {
+        std::streamsize n = in.gcount();
+        for (std::streamsize i = 0; i < n; i++)
+        {
+            h ^= static_cast<unsigned char>(buf[i]);
+            h *= 1099511628211ULL;
+        }
+    }
+
+    std::ostringstream out;
+    out << std::hex << std::setw(16) << std::setfill('0') << h;
+    return out.str();
+}
+
+/*
+ * @brief Compute the content hash of a file.
+ *
+ * Streams the file through SHA-256 so large files are never
+ * held in memory at once.
+ *
+ * @param path The file to hash.
+ * @param legacy Use the old 64-bit FNV-1a hash (for checking old manifests).
+ * @return The hash as lowercase hex digits.
+ */
+std::string Manifest::hashFile(const std::string &path, bool legacy)
+{
+    std::ifstream in(path, std::ios::binary);
+
+    if (legacy)
+        return fnv1a(in);
+
+    Sha256 ctx;
+    char buf[65536];
+
+    while (in.read(buf, sizeof(buf)) || in.gcount() > 0)
+        ctx.update(buf, in.gcount());
+
+    return Hash::hex(ctx.finish());
+}
+
+/*
+ * @brief Hash many files.
+ *
+ * Small files are read whole and passed to the multi-buffer kernel
+ * eight at a time; larger ones are streamed one by one.
+ *
+ * @param paths Files to hash.
+ * @return The hashes, in the same order as paths.
+ */
+std::vector<std::string> Manifest::hashFiles(const std::vector<std::string> &paths)
+{
+    std::vector<std::string> result(paths.size());
+    std::vector<std::size_t> small;
+    std::vector<std::string> contents;
+
+    auto flush = [&]()
+    {
+        std::vector<const unsigned char *> data;
+        std::vector<std::size_t> len;
+        for (auto &c : contents)
+        {
+            data.push_back(reinterpret_cast<const unsigned char *>(c.data()));
+            len.push_back(c.size());
+        }
+
+        std::vector<Digest> digests(contents.size());
+        Hash::sha256Many(data.data(), len.data(), contents.size(), digests.data());
+
+        for (std::size_t i = 0; i < small.size(); i++)
+            result[small[i]] = Hash::hex(digests[i]);
+
+        small.clear();
+        contents.clear();
+    };
+
+    for (std::size_t i = 0; i < paths.size(); i++)
+    {
+        std::error_code ec;
+        auto size = fs::file_size(paths[i], ec);
+
+        if (ec || size > SMALL_FILE)
+        {
+            result[i] = hashFile(paths[i]);
+            continue;
+        }
+
+        std::ifstream in(paths[i], std::ios::binary);
+        std::string content(size, '\0');
+        in.read(&content[0], size);
+        content.resize(in.gcount());
+
+        small.push_back(i);
+        contents.push_back(std::move(content));
+
+        if (small.size() == 8)
+            flush();
+    }
+
+    if (!small.empty())
+        flush();
+
+    return result;
+}
+
+/*
+ * @brief Build the manifest of a commit snapshot without saving it.
+ *
+ * Walks <commit>/files and records hash, size and relative path of
+ * every file.
+ *
+ * @param commitID The commit whose snapshot is listed.
+ * @return Map of relative path to hash and size.
+ */
+std::map<std::string, ManifestEntry> Manifest::generate(const std::string &commitID)
+{
+    fs::path filesPath = Repository::objectDir(commitID) + "/files";
+
+    std::map<std::string, ManifestEntry> entries;
+    std::vector<std::string> rels, files;
+
+    if (fs::exists(filesPath))
+    {
+        for (auto &entry : fs::recursive_directory_iterator(filesPath))
+        {
+            if (entry.is_regular_file())
+            {
+                std::string rel = fs::relative(entry.path(), filesPath).generic_string();
+                entries[rel].size = entry.file_size();
+                rels.push_back(rel);
+                files.push_back(entry.path().string());
+            }
+        }
+    }
+
+    auto hashes = hashFiles(files);
+    for (std::size_t i = 0; i < rels.size(); i++)
+        entries[rels[i]].hash = hashes[i];
+
+    return entries;
+}
+
+/*
+ * @brief Write the manifest of a commit snapshot.
+ *
+ * Written to a temporary file and renamed into place, so a manifest
+ * hardlinked into a clone is replaced rather than rewritten in place.
+ *
+ * @param commitID The commit whose snapshot is listed.
+ * @return false if the manifest could not be saved (e.g. read-only
+ *         alternate object store).
+ */
+bool Manifest::write(const std::string &commitID)
+{
+    auto entries = generate(commitID);
+    fs::path manifestPath = Repository::objectDir(commitID) + "/manifest";
+    fs::path tmpPath = manifestPath.string() + ".tmp";
+
+    {
+        std::ofstream out(tmpPath);
+        for (auto &[path, e] : entries)
+            out << e.hash << " " << e.size << " " << path << "\n";
+        if (!out)
+            return false;
+    }
+
+    std::error_code ec;
+    fs::rename(tmpPath, manifestPath, ec);
+    if (ec)
+        fs::remove(tmpPath, ec);
+    return !ec;
+}
+
+/*
+ * @brief Read a commit's manifest file exactly as stored.
+ *
+ * @param commitID The commit to read.
+ * @return Map of relative path to hash and size; empty if there is no manifest.
+ */
+std::map<std::string, ManifestEntry> Manifest::read(const std::string &commitID)
+{
+    std::map<std::string, ManifestEntry> entries;
+    std::ifstream in(Repository::objectDir(commitID) + "/manifest");
+    std::string line;
+
+    while (std::getline(in, line))
+    {
+        std::istringstream ss(line);
+        ManifestEntry e;
+        std::string path;
+
+        if (!(ss >> e.hash >> e.size))
+            continue;
+
+        ss.get();
+        std::getline(ss, path);
+        entries[path] = e;
+    }
+
+    return entries;
+}
+
+/*
+ * @brief Load the manifest of a commit.
+ *
+ * Commits created before manifests existed, or whose manifest still
+ * uses the old hash, get one generated on first use, so later lookups
+ * stay metadata-only and hashes compare across commits.
+ *
+ * @param commitID The commit to load, or NONE/empty for no commit.
+ * @return Map of relative path to hash and size.
+ */
+std::map<std::string, ManifestEntry> Manifest::load(const std::string &commitID)
+{
+    if (commitID.empty() || commitID == "NONE")
+        return {};
+
+    std::string dir = Repository::objectDir(commitID);
+    if (!fs::exists(dir))
+        return {};
+
+    auto entries = read(commitID);
+
+    bool legacy = !entries.empty() && entries.begin()->second.hash.size() == LEGACY_HASH_LENGTH;
+    if (legacy || !fs::exists(dir + "/manifest"))
+    {
+        // Saved if possible; otherwise used just for this lookup.
+        entries = write(commitID) ? read(commitID) : generate(commitID);
+    }
+
+    return entries;
+}
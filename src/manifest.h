@@ -0,0 +1,38 @@
+/*
+Manifest = listing of a commit snapshot.
+Stored next to meta:
+.mygit/objects/<commit>/manifest
+One line per file:
+<hash> <size> <path>
+<hash> is the SHA-256 of the file (64 hex digits); manifests from
+older versions used 64-bit FNV-1a (16 hex digits) and are rewritten
+by load() on first use.
+Lets merge/diff decide whether a path changed
+without opening the files themselves.
+*/
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+struct ManifestEntry
+{
+    std::string hash;
+    std::uintmax_t size = 0;
+};
+
+class Manifest
+{
+public:
+    static std::string hashFile(const std::string &path, bool legacy = false);
+    static std::vector<std::string> hashFiles(const std::vector<std::string> &paths);
+    static std::map<std::string, ManifestEntry> generate(const std::string &commitID);
+    static bool write(const std::string &commitID);
+    static std::map<std::string, ManifestEntry> read(const std::string &commitID);
+    static std::map<std::string, ManifestEntry> load(const std::string &commitID);
+};
+
+#endif
@@ -0,0 +1,724 @@
+#include "materialize.h"
+#include "uring.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define MYGIT_URING 1
+#endif
+
+namespace fs = std::filesystem;
+
+static void prepare(const fs::path &dest)
+{
+    if (!dest.parent_path().empty())
+        fs::create_directories(dest.parent_path());
+
+    std::error_code ec;
+    fs::remove(dest, ec);
+}
+
+/*
+ * @brief Clone a file with copy-on-write sharing.
+ *
+ * Uses the FICLONE ioctl (btrfs, XFS, bcachefs...). The clone shares
+ * blocks with the source until either side is written.
+ *
+ * @return true on success; false if unsupported, dest is left absent.
+ */
+bool Materialize::reflink(const fs::path &src, const fs::path &dest)
+{
+#if defined(__linux__) && defined(FICLONE)
+    int in = open(src.c_str(), O_RDONLY);
+    if (in < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(in, &st) != 0)
+    {
+        close(in);
+        return false;
+    }
+
+    int out = open(dest.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0600);
+    if (out < 0)
+    {
+        close(in);
+        return false;
+    }
+
+    // Same permissions as the source (the exec bit must survive), like copy_file.
+    bool ok = ioctl(out, FICLONE, in) == 0 && fchmod(out, st.st_mode & 07777) == 0;
+    close(in);
+    close(out);
+
+    if (!ok)
+        unlink(dest.c_str());
+    return ok;
+#else
+    (void)src;
+    (void)dest;
+    return false;
+#endif
+}
+
+void Materialize::file(const fs::path &src, const fs::path &dest)
+{
+    prepare(dest);
+
+    if (reflink(src, dest))
+        return;
+
+    fs::copy_file(src, dest, fs::copy_options::overwrite_existing);
+}
+
+/*
+ * @brief Share an object-store file with another store.
+ *
+ * Hardlinks need the same filesystem; reflinks also work across
+ * subvolumes on some filesystems; a copy always works.
+ *
+ * @return How the file was materialized.
+ */
+LinkKind Materialize::link(const fs::path &src, const fs::path &dest)
+{
+    prepare(dest);
+
+    std::error_code ec;
+    fs::create_hard_link(src, dest, ec);
+    if (!ec)
+        return LinkKind::Hardlink;
+
+    if (reflink(src, dest))
+        return LinkKind::Reflink;
+
+    fs::copy_file(src, dest, fs::copy_options::overwrite_existing);
+    return LinkKind::Copy;
+}
+
+// ---- batched materialization ----
+
+static const unsigned DEFAULT_DEPTH = 64;
+static const std::size_t CHUNK = 128 << 10;
+
+unsigned Materialize::depth()
+{
+    static const unsigned value = []
+    {
+        const char *env = std::getenv("MYGIT_IO_DEPTH");
+        unsigned long d = env ? std::strtoul(env, nullptr, 10) : DEFAULT_DEPTH;
+        return static_cast<unsigned>(std::clamp<unsigned long>(d, 1, 4096));
+    }();
+    return value;
+}
+
+static bool uringUsable()
+{
+#ifdef MYGIT_URING
+    static const bool result = []
+    {
+        Uring ring(2);
+        return ring.supports(IORING_OP_OPENAT) && ring.supports(IORING_OP_STATX) &&
+               ring.supports(IORING_OP_READ) && ring.supports(IORING_OP_WRITE) &&
+               ring.supports(IORING_OP_CLOSE);
+    }();
+    return result;
+#else
+    return false;
+#endif
+}
+
+IOEngine Materialize::engine()
+{
+    static const IOEngine value = []
+    {
+        const char *env = std::getenv("MYGIT_IO_ENGINE");
+        std::string forced = env ? env : "";
+
+        if (forced == "sequential")
+            return IOEngine::Sequential;
+        if (forced == "threads" || !uringUsable())
+            return IOEngine::Threads;
+        return IOEngine::Uring;
+    }();
+    return value;
+}
+
+const char *Materialize::engineName(IOEngine engine)
+{
+    switch (engine)
+    {
+    case IOEngine::Uring:
+        return "io_uring";
+    case IOEngine::Threads:
+        return "threads";
+    default:
+        return "sequential";
+    }
+}
+
+// Every missing ancestor of every destination, grouped by depth so a
+// level can be created in one batch once its parents exist.
+static std::vector<std::vector<std::string>> directoryLevels(const std::vector<CopyJob> &jobs)
+{
+    std::set<std::string> seen;
+    std::vector<std::vector<std::string>> levels;
+
+    for (auto &job : jobs)
+    {
+        for (fs::path dir = job.dest.parent_path();
+             !dir.empty() && dir != dir.root_path() && seen.insert(dir.string()).second;
+             dir = dir.parent_path())
+        {
+            std::size_t depth = std::distance(dir.begin(), dir.end());
+            if (levels.size() < depth)
+                levels.resize(depth);
+            levels[depth - 1].push_back(dir.string());
+        }
+    }
+
+    return levels;
+}
+
+static void makeDirectories(const std::vector<std::vector<std::string>> &levels)
+{
+    for (auto &level : levels)
+        for (auto &dir : level)
+            fs::create_directories(dir);
+}
+
+static void runSequential(const std::vector<CopyJob> &jobs)
+{
+    for (auto &job : jobs)
+        Materialize::file(job.src, job.dest);
+}
+
+static void runThreads(const std::vector<CopyJob> &jobs, std::size_t first)
+{
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    unsigned workers = std::min<std::size_t>({Materialize::depth(), 4 * cores, jobs.size() - first});
+
+    std::atomic<std::size_t> next{first};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex errorLock;
+
+    auto work = [&]
+    {
+        for (std::size_t i; !failed && (i = next++) < jobs.size();)
+        {
+            try
+            {
+                Materialize::file(jobs[i].src, jobs[i].dest);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> guard(errorLock);
+                if (!error)
+                    error = std::current_exception();
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < workers; i++)
+        pool.emplace_back(work);
+    work();
+    for (auto &t : pool)
+        t.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+#ifdef MYGIT_URING
+
+namespace
+{
+
+enum Op : std::uint64_t
+{
+    OpenSrc,
+    OpenDest,
+    Read,
+    Write,
+    Close,
+    Mkdir,
+    Stat
+};
+
+struct Slot
+{
+    std::size_t job = 0;
+    int src = -1, dest = -1;
+    unsigned waiting = 0;
+    bool failed = false;
+    off_t offset = 0;               // bytes copied before the current chunk
+    std::size_t chunk = 0, written = 0; // current chunk: read, written so far
+    struct statx stx;
+    std::vector<char> buf;
+};
+
+// One ring, up to depth files in flight, at most two requests per file.
+// Per file: openat src + statx src, openat dest with the source's mode,
+// then read/write chunks up to the stat size, then close both.
+// Thrown when the ring cannot take more requests.
+struct RingFailed
+{
+};
+
+class UringCopier
+{
+public:
+    UringCopier(const std::vector<CopyJob> &jobs, unsigned depth)
+        : jobs_(jobs), ring_(2 * depth), slots_(depth)
+    {
+        for (unsigned i = 0; i < depth; i++)
+            free_.push_back(depth - 1 - i);
+
+        umask_ = umask(0);
+        umask(umask_);
+    }
+
+    bool ok() const { return ring_.ok(); }
+
+    bool makeDirectories(const std::vector<std::vector<std::string>> &levels)
+    {
+        if (!ring_.supports(IORING_OP_MKDIRAT))
+            return false;
+
+        for (auto &level : levels)
+        {
+            for (std::size_t i = 0; i < level.size();)
+            {
+                unsigned queued = 0;
+                for (; i < level.size() && queued < 2 * slots_.size(); i++, queued++)
+                {
+                    io_uring_sqe *e = ring_.sqe();
+                    if (!e)
+                        break;
+                    e->opcode = IORING_OP_MKDIRAT;
+                    e->fd = AT_FDCWD;
+                    e->addr = reinterpret_cast<std::uint64_t>(level[i].c_str());
+                    e->len = 0777;
+                    e->user_data = Mkdir;
+                }
+
+                // EEXIST is the common case; anything else surfaces
+                // when the file inside is opened.
+                while (queued > 0)
+                {
+                    if (ring_.submitAndWait(1) < 0)
+                        return false;
+                    queued -= ring_.reap([](std::uint64_t, int) {});
+                }
+            }
+        }
+        return true;
+    }
+
+    // @return false if the ring itself failed; retry is then needed
+    //         for every job not in done().
+    bool run()
+    {
+        done_.assign(jobs_.size(), false);
+        std::size_t next = 0, active = 0;
+
+        try
+        {
+            while (next < jobs_.size() || active > 0)
+            {
+                while (next < jobs_.size() && !free_.empty())
+                {
+                    start(free_.back(), next++);
+                    free_.pop_back();
+                    active++;
+                }
+
+                if (ring_.submitAndWait(1) < 0)
+                    throw RingFailed();
+
+                ring_.reap([&](std::uint64_t data, int res)
+                {
+                    if (complete(data >> 3, static_cast<Op>(data & 7), res))
+                        active--;
+                });
+            }
+        }
+        catch (const RingFailed &)
+        {
+            for (auto &s : slots_)
+            {
+                if (s.src >= 0)
+                    ::close(s.src);
+                if (s.dest >= 0)
+                    ::close(s.dest);
+                s.src = s.dest = -1;
+            }
+            return false;
+        }
+        return true;
+    }
+
+    const std::vector<bool> &done() const { return done_; }
+
+private:
+    const std::vector<CopyJob> &jobs_;
+    Uring ring_;
+    std::vector<Slot> slots_;
+    std::vector<std::size_t> free_;
+    std::vector<bool> done_;
+    mode_t umask_;
+
+    io_uring_sqe *queue(std::size_t slot, Op op, int fd)
+    {
+        // A full submission queue is handed to the kernel, which frees
+        // its entries; completions are reaped by run() as usual.
+        io_uring_sqe *e;
+        while (!(e = ring_.sqe()))
+        {
+            if (ring_.submitAndWait(0) < 0)
+                throw RingFailed();
+        }
+
+        e->fd = fd;
+        e->user_data = slot << 3 | op;
+        slots_[slot].waiting++;
+        return e;
+    }
+
+    void open(std::size_t slot, Op op, const fs::path &path, int flags, mode_t mode = 0)
+    {
+        io_uring_sqe *e = queue(slot, op, AT_FDCWD);
+        e->opcode = IORING_OP_OPENAT;
+        e->addr = reinterpret_cast<std::uint64_t>(path.c_str());
+        e->open_flags = flags | O_CLOEXEC;
+        e->len = mode;
+    }
+
+    void stat(std::size_t slot, const fs::path &path)
+    {
+        io_uring_sqe *e = queue(slot, Stat, AT_FDCWD);
+        e->opcode = IORING_OP_STATX;
+        e->addr = reinterpret_cast<std::uint64_t>(path.c_str());
+        e->len = STATX_MODE | STATX_SIZE;
+        e->off = reinterpret_cast<std::uint64_t>(&slots_[slot].stx);
+    }
+
+    void read(std::size_t slot)
+    {
+        Slot &s = slots_[slot];
+        io_uring_sqe *e = queue(slot, Read, s.src);
+        e->opcode = IORING_OP_READ;
+        e->addr = reinterpret_cast<std::uint64_t>(s.buf.data());
+        e->len = CHUNK;
+        e->off = s.offset;
+    }
+
+    // Writes what is left of the current chunk.
+    void write(std::size_t slot)
+    {
+        Slot &s = slots_[slot];
+        io_uring_sqe *e = queue(slot, Write, s.dest);
+        e->opcode = IORING_OP_WRITE;
+        e->addr = reinterpret_cast<std::uint64_t>(s.buf.data() + s.written);
+        e->len = s.chunk - s.written;
+        e->off = s.offset + s.written;
+    }
+
+    void closeFd(std::size_t slot, int &fd)
+    {
+        if (fd < 0)
+            return;
+        io_uring_sqe *e = queue(slot, Close, fd);
+        e->opcode = IORING_OP_CLOSE;
+        fd = -1;
+    }
+
+    void start(std::size_t slot, std::size_t job)
+    {
+        Slot &s = slots_[slot];
+        s.job = job;
+        s.failed = false;
+        s.offset = 0;
+        if (s.buf.empty())
+            s.buf.resize(CHUNK);
+
+        open(slot, OpenSrc, jobs_[job].src, O_RDONLY);
+        stat(slot, jobs_[job].src);
+    }
+
+    void finish(std::size_t slot)
+    {
+        Slot &s = slots_[slot];
+        closeFd(slot, s.src);
+        closeFd(slot, s.dest);
+    }
+
+    // @return true when the slot is released.
+    bool complete(std::size_t slot, Op op, int res)
+    {
+        Slot &s = slots_[slot];
+        s.waiting--;
+
+        switch (op)
+        {
+        case OpenSrc:
+        case Stat:
+            if (op == OpenSrc)
+                s.src = res;
+            s.failed |= res < 0 || (op == Stat && !(s.stx.stx_mask & STATX_SIZE));
+            if (s.waiting == 0)
+            {
+                // O_EXCL: an existing destination goes back to file(),
+                // which replaces it instead of writing through it.
+                if (s.failed)
+                    finish(slot);
+                else
+                    open(slot, OpenDest, jobs_[s.job].dest, O_WRONLY | O_CREAT | O_EXCL,
+                         s.stx.stx_mode & 07777);
+            }
+            break;
+
+        case OpenDest:
+            s.dest = res;
+            // The umask applies to openat; restore what it took away,
+            // as copy_file does.
+            if (res < 0 || ((s.stx.stx_mode & umask_ & 07777) &&
+                            fchmod(res, s.stx.stx_mode & 07777) != 0))
+            {
+                s.failed = true;
+                finish(slot);
+            }
+            else if (s.stx.stx_size == 0)
+                finish(slot);
+            else
+                read(slot);
+            break;
+
+        case Read:
+            // Reads may come back short; only the stat size ends the copy.
+            // End of file before it means the source shrank under us.
+            if (res <= 0)
+            {
+                s.failed |= res < 0 || static_cast<std::uint64_t>(s.offset) < s.stx.stx_size;
+                finish(slot);
+            }
+            else
+            {
+                s.chunk = res;
+                s.written = 0;
+                write(slot);
+            }
+            break;
+
+        case Write:
+            if (res <= 0)
+            {
+                s.failed = true;
+                finish(slot);
+                break;
+            }
+
+            s.written += res;
+            if (s.written < s.chunk)
+                write(slot);
+            else
+            {
+                s.offset += s.chunk;
+                if (static_cast<std::uint64_t>(s.offset) >= s.stx.stx_size)
+                    finish(slot);
+                else
+                    read(slot);
+            }
+            break;
+
+        default:
+            s.failed |= res < 0;
+            break;
+        }
+
+        if (s.waiting > 0)
+            return false;
+
+        done_[s.job] = !s.failed;
+        free_.push_back(slot);
+        return true;
+    }
+};
+
+}
+
+static void runUring(const std::vector<CopyJob> &jobs,
+                     const std::vector<std::vector<std::string>> &levels)
+{
+    UringCopier copier(jobs, Materialize::depth());
+    if (!copier.ok())
+    {
+        makeDirectories(levels);
+        runThreads(jobs, 0);
+        return;
+    }
+
+    if (!copier.makeDirectories(levels))
+        makeDirectories(levels);
+
+    copier.run();
+
+    // Whatever the ring did not finish is redone (or reported) by file().
+    for (std::size_t i = 0; i < jobs.size(); i++)
+        if (!copier.done()[i])
+            Materialize::file(jobs[i].src, jobs[i].dest);
+}
+
+#endif
+
+/*
+ * @brief Materialize many files with a given engine.
+ *
+ * @throws fs::filesystem_error for the first file that cannot be written.
+ */
+void Materialize::files(const std::vector<CopyJob> &jobs, IOEngine engine)
+{
+    if (jobs.empty())
+        return;
+
+    if (engine == IOEngine::Sequential)
+    {
+        runSequential(jobs);
+        return;
+    }
+
+    auto levels = directoryLevels(jobs);
+
+#ifdef MYGIT_URING
+    if (engine == IOEngine::Uring && uringUsable())
+    {
+        runUring(jobs, levels);
+        return;
+    }
+#endif
+
+    makeDirectories(levels);
+    runThreads(jobs, 0);
+}
+
+void Materialize::files(const std::vector<CopyJob> &jobs)
+{
+    IOEngine chosen = engine();
+
+    if (jobs.empty() || chosen == IOEngine::Sequential)
+    {
+        files(jobs, chosen);
+        return;
+    }
+
+    // Copy-on-write filesystem: clone everything instead of copying.
+    prepare(jobs[0].dest);
+    if (reflink(jobs[0].src, jobs[0].dest))
+    {
+        makeDirectories(directoryLevels(jobs));
+        runThreads(jobs, 1);
+        return;
+    }
+
+    files(jobs, chosen);
+}
+
+// ---- benchmark ----
+
+static bool sameContent(const fs::path &a, const fs::path &b)
+{
+    std::ifstream x(a, std::ios::binary), y(b, std::ios::binary);
+    std::string p((std::istreambuf_iterator<char>(x)), std::istreambuf_iterator<char>());
+    std::string q((std::istreambuf_iterator<char>(y)), std::istreambuf_iterator<char>());
+    return x && y && p == q;
+}
+
+/*
+ * @brief Time every engine on a generated tree of count files.
+ *
+ * Sources are written first, so they are in the page cache and the
+ * run measures syscall cost rather than the device. Files go 100 to a
+ * directory, 10 directories to a parent, like a source tree.
+ */
+void Materialize::benchmark(std::size_t count, std::size_t size)
+{
+    auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    fs::path base = fs::temp_directory_path() / ("mygit-bench-" + std::to_string(stamp));
+    fs::remove_all(base);
+
+    std::string content(size, '\0');
+    for (std::size_t i = 0; i < size; i++)
+        content[i] = "abcdefghijklmnopqrstuvwxyz\n"[i % 27];
+
+    std::vector<std::string> rels;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        std::string rel = "d" + std::to_string(i / 1000) + "/e" + std::to_string(i / 100 % 10) +
+                          "/f" + std::to_string(i) + ".txt";
+        fs::create_directories((base / "src" / rel).parent_path());
+        std::ofstream(base / "src" / rel, std::ios::binary) << content << i;
+        rels.push_back(rel);
+    }
+
+    std::cout << count << " files of " << size << " bytes, depth " << depth()
+              << ", default engine " << engineName(engine()) << "\n";
+
+    std::vector<IOEngine> engines{IOEngine::Sequential, IOEngine::Threads};
+    if (uringUsable())
+        engines.push_back(IOEngine::Uring);
+    else
+        std::cout << std::left << std::setw(12) << "io_uring" << "unavailable\n" << std::right;
+
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (IOEngine e : engines)
+    {
+        fs::path out = base / engineName(e);
+        std::vector<CopyJob> jobs;
+        for (auto &rel : rels)
+            jobs.push_back({base / "src" / rel, out / rel});
+
+        auto start = std::chrono::steady_clock::now();
+        files(jobs, e);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        bool ok = sameContent(jobs.front().src, jobs.front().dest) &&
+                  sameContent(jobs.back().src, jobs.back().dest);
+
+        std::cout << std::left << std::setw(12) << engineName(e) << std::right << std::setw(9)
+                  << seconds << " s  " << std::setw(9) << std::setprecision(0)
+                  << (seconds > 0 ? count / seconds : 0) << " files/s" << (ok ? "" : "  MISMATCH")
+                  << "\n" << std::setprecision(3);
+
+        fs::remove_all(out);
+    }
+
+    fs::path probe = base / "reflink-probe";
+    std::cout << std::left << std::setw(12) << "reflink" << std::right << (reflink(base / "src" / rels.front(), probe) ? "yes" : "no") << "\n";
+
+    fs::remove_all(base);
+}
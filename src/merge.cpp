@@ -0,0 +1,531 @@
+#include "merge.h"
+#include "repostate.h"
+#include "commit.h"
+#include "manifest.h"
+#include "materialize.h"
+#include "objectcache.h"
+#include "repository.h"
+#include "sparse.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <queue>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static std::string getCurrentBranch()
+{
+    std::string ref = RepoState::firstLine(".mygit/HEAD");
+    return ref.substr(ref.find_last_of('/') + 1);
+}
+
+static std::string getBranchHeadCommit(const std::string &branch)
+{
+    std::string commit = RepoState::firstLine(".mygit/branches/" + branch);
+    return commit.empty() ? "NONE" : commit;
+}
+
+static void updateBranchHead(const std::string &branch, const std::string &commitID)
+{
+    std::ofstream out(".mygit/branches/" + branch);
+    out << commitID;
+}
+
+static bool indexIsEmpty()
+{
+    return RepoState::lines(".mygit/index")->empty();
+}
+
+struct CommitNode
+{
+    std::vector<std::string> parents;
+    unsigned long generation = 0;
+};
+
+static CommitNode readNode(const std::string &commitID)
+{
+    CommitNode node;
+    auto meta = ObjectCache::meta(commitID);
+
+    if (meta)
+    {
+        node.parents = meta->parents;
+        node.generation = meta->generation;
+    }
+
+    if (node.generation == 0)
+        node.generation = Commit::generation(commitID);
+
+    return node;
+}
+
+/*
+ * @brief Find the merge base of two commits.
+ *
+ * Paints commits reachable from A and from B while always expanding
+ * the highest generation first. A parent always has a lower generation
+ * than its child, so the first commit popped carrying both colours is
+ * a best common ancestor and nothing below it is ever visited.
+ *
+ * @param commitA First commit.
+ * @param commitB Second commit.
+ * @return The merge base, or NONE if the histories are unrelated.
+ */
+std::string Merge::base(const std::string &commitA, const std::string &commitB)
+{
+    if (commitA == "NONE" || commitB == "NONE")
+        return "NONE";
+
+    const int FROM_A = 1, FROM_B = 2, BOTH = FROM_A | FROM_B;
+
+    std::unordered_map<std::string, int> flags;
+    std::unordered_map<std::string, CommitNode> nodes;
+    std::priority_queue<std::pair<unsigned long, std::string>> queue;
+
+    auto enqueue = [&](const std::string &id, int flag)
+    {
+        bool seen = flags.count(id) > 0;
+        flags[id] |= flag;
+        if (!seen)
+        {
+            nodes[id] = readNode(id);
+            queue.push({nodes[id].generation, id});
+        }
+    };
+
+    enqueue(commitA, FROM_A);
+    enqueue(commitB, FROM_B);
+
+    while (!queue.empty())
+    {
+        std::string id = queue.top().second;
+        queue.pop();
+
+        int f = flags[id];
+        if (f == BOTH)
+            return id;
+
+        for (auto &p : nodes[id].parents)
+            enqueue(p, f);
+    }
+
+    return "NONE";
+}
+
+static std::vector<std::string> readLines(const fs::path &file)
+{
+    return *ObjectCache::lines(file.string());
+}
+
+// For each line of A, the index of the LCS-matched line in B or -1.
+static std::vector<int> matchLines(const std::vector<std::string> &A,
+                                   const std::vector<std::string> &B)
+{
+    int n = A.size(), m = B.size();
+    std::vector<std::vector<int>> dp(n + 1, std::vector<int>(m + 1));
+
+    for (int i = n - 1; i >= 0; i--)
+        for (int j = m - 1; j >= 0; j--)
+            if (A[i] == B[j])
+                dp[i][j] = dp[i + 1][j + 1] + 1;
+            else
+                dp[i][j] = std::max(dp[i + 1][j], dp[i][j + 1]);
+
+    std::vector<int> match(n, -1);
+    int i = 0, j = 0;
+    while (i < n && j < m)
+    {
+        if (A[i] == B[j])
+            match[i++] = j++;
+        else if (dp[i + 1][j] >= dp[i][j + 1])
+            i++;
+        else
+            j++;
+    }
+
+    return match;
+}
+
+/*
+ * @brief Line-level three-way merge (diff3).
+ *
+ * Base lines matched in both ours and theirs are stable; everything
+ * between two stable lines is a chunk that resolves to whichever side
+ * changed it, or to a conflict if both did differently.
+ *
+ * @param out Receives the merged lines, with conflict markers if needed.
+ * @return true if the merge was clean.
+ */
+static bool mergeLines(const std::vector<std::string> &base,
+                       const std::vector<std::string> &ours,
+                       const std::vector<std::string> &theirs,
+                       const std::string &theirName,
+                       std::vector<std::string> &out)
+{
+    auto mo = matchLines(base, ours);
+    auto mt = matchLines(base, theirs);
+
+    int nb = base.size(), no = ours.size(), nt = theirs.size();
+    int i = 0, o = 0, t = 0;
+    bool clean = true;
+
+    while (i < nb || o < no || t < nt)
+    {
+        if (i < nb && mo[i] == o && mt[i] == t)
+        {
+            out.push_back(base[i]);
+            i++, o++, t++;
+            continue;
+        }
+
+        int j = i;
+        while (j < nb && (mo[j] == -1 || mt[j] == -1))
+            j++;
+
+        int oe = j < nb ? mo[j] : no;
+        int te = j < nb ? mt[j] : nt;
+
+        std::vector<std::string> b(base.begin() + i, base.begin() + j);
+        std::vector<std::string> a(ours.begin() + o, ours.begin() + oe);
+        std::vector<std::string> c(theirs.begin() + t, theirs.begin() + te);
+
+        if (a == b || a == c)
+            out.insert(out.end(), c.begin(), c.end());
+        else if (c == b)
+            out.insert(out.end(), a.begin(), a.end());
+        else
+        {
+            clean = false;
+            out.push_back("<<<<<<< ours");
+            out.insert(out.end(), a.begin(), a.end());
+            out.push_back("=======");
+            out.insert(out.end(), c.begin(), c.end());
+            out.push_back(">>>>>>> " + theirName);
+        }
+
+        i = j, o = oe, t = te;
+    }
+
+    return clean;
+}
+
+static const char *MERGE_SOURCES = ".mygit/MERGE_SOURCES";
+static const char *MERGE_RESULTS = ".mygit/merge-results";
+
+static fs::path snapshotFile(const std::string &commitID, const std::string &path)
+{
+    return fs::path(Repository::objectDir(commitID) + "/files") / path;
+}
+
+static void writeFromSnapshot(const std::string &commitID, const std::string &path)
+{
+    Materialize::file(snapshotFile(commitID, path), path);
+}
+
+/*
+ * @brief Working-tree files the merge would overwrite or delete that
+ *        do not match ours.
+ *
+ * A path ours tracks counts as changed when its size or hash differs or
+ * the file is gone; a path ours does not track counts when a file is in
+ * the way.
+ */
+static std::vector<std::string> localChanges(const std::vector<std::string> &touched,
+                                             const std::map<std::string, ManifestEntry> &treeO)
+{
+    std::vector<std::string> dirty, toHash;
+    std::vector<const ManifestEntry *> expected;
+
+    for (auto &path : touched)
+    {
+        // Outside the sparse set nothing is on disk to lose.
+        if (!Sparse::includes(path))
+            continue;
+
+        std::error_code ec;
+        auto size = fs::file_size(path, ec);
+        auto it = treeO.find(path);
+
+        if (it == treeO.end())
+        {
+            if (!ec)
+                dirty.push_back(path);
+        }
+        else if (ec || size != it->second.size)
+            dirty.push_back(path);
+        else
+        {
+            toHash.push_back(path);
+            expected.push_back(&it->second);
+        }
+    }
+
+    auto hashes = Manifest::hashFiles(toHash);
+    for (std::size_t i = 0; i < toHash.size(); i++)
+        if (hashes[i] != expected[i]->hash)
+            dirty.push_back(toHash[i]);
+
+    std::sort(dirty.begin(), dirty.end());
+    return dirty;
+}
+
+static bool refuseLocalChanges(const std::vector<std::string> &touched,
+                               const std::map<std::string, ManifestEntry> &treeO)
+{
+    auto dirty = localChanges(touched, treeO);
+    if (dirty.empty())
+        return false;
+
+    std::cout << "Your local changes to these files would be overwritten by merge:\n";
+    for (auto &p : dirty)
+        std::cout << "  " << p << "\n";
+    std::cout << "Commit or revert them, then merge again.\n";
+    return true;
+}
+
+static void fastForward(const std::string &branch,
+                        const std::string &ours,
+                        const std::string &theirs)
+{
+    auto treeO = Manifest::load(ours);
+    auto treeT = Manifest::load(theirs);
+
+    std::vector<std::string> removed, written;
+    for (auto &[path, e] : treeO)
+        if (!treeT.count(path))
+            removed.push_back(path);
+
+    for (auto &[path, e] : treeT)
+    {
+        auto it = treeO.find(path);
+        if (it == treeO.end() || it->second.hash != e.hash)
+            written.push_back(path);
+    }
+
+    std::vector<std::string> touched = removed;
+    touched.insert(touched.end(), written.begin(), written.end());
+    if (refuseLocalChanges(touched, treeO))
+        return;
+
+    for (auto &path : removed)
+        if (Sparse::includes(path) && fs::exists(path))
+            fs::remove(path);
+
+    for (auto &path : written)
+        if (Sparse::includes(path))
+            writeFromSnapshot(theirs, path);
+
+    updateBranchHead(branch, theirs);
+    std::cout << "Fast-forward to " << theirs << "\n";
+}
+
+// What the merge result holds for one path.
+enum class Take
+{
+    Ours,   // unchanged from HEAD, nothing to write
+    Theirs, // theirs' snapshot file
+    Delete, // removed by theirs
+    Lines   // line-level merge of base/ours/theirs
+};
+
+struct Step
+{
+    std::string path;
+    Take take;
+    bool conflict; // modified on one side, deleted on the other
+};
+
+void Merge::run(const std::string &branch)
+{
+    if (!Repository::exists())
+    {
+        std::cout << "Not a mygit repository.\n";
+        return;
+    }
+
+    if (!fs::exists(".mygit/branches/" + branch))
+    {
+        std::cout << "Branch '" << branch << "' does not exist.\n";
+        return;
+    }
+
+    if (fs::exists(".mygit/MERGE_HEAD"))
+    {
+        std::cout << "A merge is in progress. Resolve conflicts, add and commit first.\n";
+        return;
+    }
+
+    if (!indexIsEmpty())
+    {
+        std::cout << "You have staged changes. Commit or clear them before merge.\n";
+        return;
+    }
+
+    std::string current = getCurrentBranch();
+    std::string ours = getBranchHeadCommit(current);
+    std::string theirs = getBranchHeadCommit(branch);
+
+    if (theirs == "NONE")
+    {
+        std::cout << "Branch '" << branch << "' has no commits.\n";
+        return;
+    }
+
+    std::string base = Merge::base(ours, theirs);
+
+    if (base == theirs)
+    {
+        std::cout << "Already up to date.\n";
+        return;
+    }
+
+    if (ours == "NONE" || base == ours)
+    {
+        fastForward(current, ours, theirs);
+        return;
+    }
+
+    auto treeB = Manifest::load(base);
+    auto treeO = Manifest::load(ours);
+    auto treeT = Manifest::load(theirs);
+
+    std::set<std::string> paths;
+    for (auto &[p, e] : treeO) paths.insert(p);
+    for (auto &[p, e] : treeT) paths.insert(p);
+
+    auto hashOf = [](const std::map<std::string, ManifestEntry> &tree, const std::string &p)
+    {
+        auto it = tree.find(p);
+        return it == tree.end() ? std::string() : it->second.hash;
+    };
+
+    // Decide every path before touching the working tree.
+    std::vector<Step> steps;
+    std::vector<std::string> touched;
+
+    for (auto &path : paths)
+    {
+        std::string b = hashOf(treeB, path);
+        std::string o = hashOf(treeO, path);
+        std::string t = hashOf(treeT, path);
+
+        Step step{path, Take::Ours, false};
+
+        if (o == t || t == b)
+            step.take = Take::Ours; // Nothing new from theirs
+        else if (o == b)
+            step.take = t.empty() ? Take::Delete : Take::Theirs; // Only theirs changed it
+        else if (o.empty() || t.empty())
+        {
+            // Modified on one side, deleted on the other: keep the modification
+            step.take = t.empty() ? Take::Ours : Take::Theirs;
+            step.conflict = true;
+        }
+        else
+            step.take = Take::Lines;
+
+        if (step.take != Take::Ours)
+            touched.push_back(path);
+        steps.push_back(step);
+    }
+
+    if (refuseLocalChanges(touched, treeO))
+        return;
+
+    // Results outside the sparse set stay off disk: the commit copies
+    // them from the snapshot they come from (MERGE_SOURCES), clean line
+    // merges from .mygit/merge-results.
+    fs::remove(MERGE_SOURCES);
+    fs::remove_all(MERGE_RESULTS);
+
+    std::vector<std::string> result, conflicts;
+    std::vector<std::pair<std::string, fs::path>> sources;
+    int merged = 0;
+
+    for (auto &step : steps)
+    {
+        const std::string &path = step.path;
+        bool inSet = Sparse::includes(path);
+
+        if (step.take == Take::Delete)
+        {
+            if (inSet && fs::exists(path))
+                fs::remove(path);
+            continue;
+        }
+
+        if (!inSet && step.take != Take::Lines)
+            sources.push_back({path, snapshotFile(step.take == Take::Ours ? ours : theirs, path)});
+        else if (step.take == Take::Theirs)
+            writeFromSnapshot(theirs, path);
+        else if (step.take == Take::Lines)
+        {
+            std::vector<std::string> baseLines;
+            if (treeB.count(path))
+                baseLines = readLines(snapshotFile(base, path));
+
+            std::vector<std::string> lines;
+            bool clean = mergeLines(baseLines,
+                                    readLines(snapshotFile(ours, path)),
+                                    readLines(snapshotFile(theirs, path)),
+                                    branch, lines);
+
+            // A conflict outside the sparse set still has to be resolved
+            // by hand, so only clean results are kept off disk.
+            fs::path target = path;
+            if (!inSet && clean)
+            {
+                target = fs::path(MERGE_RESULTS) / path;
+                sources.push_back({path, target});
+            }
+            if (target.has_parent_path())
+                fs::create_directories(target.parent_path());
+
+            std::ofstream out(target, std::ios::trunc);
+            for (auto &l : lines)
+                out << l << "\n";
+
+            merged++;
+            step.conflict = !clean;
+        }
+
+        result.push_back(path);
+        if (step.conflict)
+            conflicts.push_back(path);
+    }
+
+    // Stage the merged tree; the next commit records both parents.
+    {
+        std::ofstream index(".mygit/index", std::ios::trunc);
+        for (auto &p : result)
+            index << p << "\n";
+
+        std::ofstream mergeHead(".mygit/MERGE_HEAD");
+        mergeHead << theirs;
+
+        if (!sources.empty())
+        {
+            std::ofstream out(MERGE_SOURCES);
+            for (auto &[p, src] : sources)
+                out << p << "\t" << src.string() << "\n";
+        }
+    }
+
+    std::cout << "Merge base " << base << ", " << merged << " file(s) merged line by line.\n";
+
+    if (!conflicts.empty())
+    {
+        std::cout << "Conflicts in:\n";
+        for (auto &c : conflicts)
+            std::cout << "  " << c << "\n";
+        std::cout << "Fix them, then run 'mygit commit'.\n";
+        return;
+    }
+
+    Commit::create("Merge branch '" + branch + "'");
+}
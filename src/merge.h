@@ -0,0 +1,27 @@
+/*
+Three-way merge:
+    base   = best common ancestor of HEAD and <branch>
+    ours   = HEAD commit
+    theirs = <branch> commit
+Merge base is found by walking parents highest generation first,
+so the walk stops at the first commit reachable from both sides.
+Per path (compared by manifest hash only):
+    ours == theirs  -> keep
+    ours == base    -> take theirs
+    theirs == base  -> keep ours
+    otherwise       -> line-level merge of base/ours/theirs
+*/
+#ifndef MERGE_H
+#define MERGE_H
+
+#include <string>
+
+class Merge
+{
+public:
+    static std::string base(const std::string &commitA,
+                            const std::string &commitB);
+    static void run(const std::string &branch);
+};
+
+#endif
@@ -0,0 +1,318 @@
+#include "objectcache.h"
+#include "repository.h"
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const std::size_t SHARD_COUNT = 16;
+static const std::size_t DEFAULT_BUDGET = 256u << 20;
+static const std::size_t MMAP_THRESHOLD = 64u << 10;
+
+Blob::Blob(std::string bytes)
+    : owned_(std::move(bytes)), data_(owned_.data()), size_(owned_.size()), mapped_(false)
+{
+}
+
+Blob::Blob(const char *mapped, std::size_t size)
+    : data_(mapped), size_(size), mapped_(true)
+{
+}
+
+Blob::~Blob()
+{
+#ifndef _WIN32
+    if (mapped_)
+        munmap(const_cast<char *>(data_), size_);
+#endif
+}
+
+struct CacheEntry
+{
+    std::shared_ptr<const void> value;
+    std::size_t bytes;
+    std::list<std::string>::iterator pos;
+};
+
+struct Shard
+{
+    std::mutex lock;
+    std::list<std::string> lru; // front = most recently used
+    std::unordered_map<std::string, CacheEntry> entries;
+    std::size_t bytes = 0;
+};
+
+static Shard *shards()
+{
+    static Shard all[SHARD_COUNT];
+    return all;
+}
+
+static std::atomic<std::size_t> &budget()
+{
+    static std::atomic<std::size_t> value([]
+    {
+        const char *env = std::getenv("MYGIT_CACHE_BYTES");
+        return env ? static_cast<std::size_t>(std::strtoull(env, nullptr, 10)) : DEFAULT_BUDGET;
+    }());
+    return value;
+}
+
+static std::atomic<std::uint64_t> hitCount{0}, missCount{0}, evictCount{0};
+
+static Shard &shardFor(const std::string &key)
+{
+    return shards()[std::hash<std::string>{}(key) % SHARD_COUNT];
+}
+
+// Drop least recently used entries until the shard fits its share of the budget.
+// The newest entry always stays, so one oversized object still gets reused.
+static void evict(Shard &s)
+{
+    std::size_t limit = budget() / SHARD_COUNT;
+
+    while (s.bytes > limit && s.lru.size() > 1)
+    {
+        auto it = s.entries.find(s.lru.back());
+        s.bytes -= it->second.bytes;
+        s.entries.erase(it);
+        s.lru.pop_back();
+        evictCount++;
+    }
+}
+
+/*
+ * @brief Look up a cache entry, loading it on a miss.
+ *
+ * The loader runs without the shard lock held so slow disk reads
+ * on one key never block other keys in the same shard.
+ *
+ * @param key    Cache key (kind prefix + path or commit).
+ * @param loader Returns the value and its size in bytes; a null
+ *               value means "not found" and is not cached.
+ */
+template <typename T, typename Loader>
+static std::shared_ptr<const T> lookup(const std::string &key, Loader loader)
+{
+    Shard &s = shardFor(key);
+
+    {
+        std::lock_guard<std::mutex> guard(s.lock);
+        auto it = s.entries.find(key);
+        if (it != s.entries.end())
+        {
+            s.lru.splice(s.lru.begin(), s.lru, it->second.pos);
+            hitCount++;
+            return std::static_pointer_cast<const T>(it->second.value);
+        }
+    }
+
+    missCount++;
+    std::size_t bytes = 0;
+    std::shared_ptr<const T> value = loader(bytes);
+    if (!value)
+        return value;
+
+    std::lock_guard<std::mutex> guard(s.lock);
+    auto it = s.entries.find(key);
+    if (it != s.entries.end())
+        return std::static_pointer_cast<const T>(it->second.value);
+
+    s.lru.push_front(key);
+    s.entries[key] = {value, bytes + key.size(), s.lru.begin()};
+    s.bytes += bytes + key.size();
+    evict(s);
+
+    return value;
+}
+
+static std::shared_ptr<const Blob> loadBlob(const std::string &path)
+{
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= MMAP_THRESHOLD)
+    {
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (p != MAP_FAILED)
+            return std::make_shared<const Blob>(static_cast<const char *>(p), st.st_size);
+    }
+    else
+    {
+        close(fd);
+    }
+#endif
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open())
+        return nullptr;
+
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    return std::make_shared<const Blob>(ss.str());
+}
+
+std::shared_ptr<const Blob> ObjectCache::blob(const std::string &path)
+{
+    return lookup<Blob>("blob:" + path, [&](std::size_t &bytes)
+    {
+        auto b = loadBlob(path);
+        bytes = b ? b->size() : 0;
+        return b;
+    });
+}
+
+/*
+ * @brief File contents split into lines.
+ *
+ * Same result as reading with std::getline: '\n' separates lines and
+ * a final newline does not produce an empty trailing line.
+ *
+ * @param path Path to a file inside the object store.
+ * @return The lines; empty if the file does not exist.
+ */
+std::shared_ptr<const std::vector<std::string>> ObjectCache::lines(const std::string &path)
+{
+    auto result = lookup<std::vector<std::string>>("lines:" + path, [&](std::size_t &bytes)
+    {
+        // Split from a private read: going through blob() would keep the
+        // bytes cached twice, once whole and once as lines.
+        std::shared_ptr<std::vector<std::string>> out;
+        auto b = loadBlob(path);
+        if (!b)
+            return std::shared_ptr<const std::vector<std::string>>(out);
+
+        out = std::make_shared<std::vector<std::string>>();
+        const char *p = b->data(), *end = p + b->size();
+        while (p < end)
+        {
+            const char *nl = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            const char *stop = nl ? nl : end;
+            out->emplace_back(p, stop);
+            bytes += sizeof(std::string) + (stop - p);
+            p = nl ? nl + 1 : end;
+        }
+
+        return std::shared_ptr<const std::vector<std::string>>(out);
+    });
+
+    if (!result)
+        return std::make_shared<const std::vector<std::string>>();
+    return result;
+}
+
+// A damaged number reads as 0 (unknown), so callers fall back to
+// walking parents instead of failing.
+static unsigned long parseGeneration(const std::string &digits)
+{
+    if (digits.empty() || digits.size() > 9)
+        return 0;
+    for (char c : digits)
+        if (!std::isdigit(static_cast<unsigned char>(c)))
+            return 0;
+    return std::stoul(digits);
+}
+
+std::shared_ptr<const CommitMeta> ObjectCache::meta(const std::string &commitID)
+{
+    if (commitID.empty() || commitID == "NONE")
+        return nullptr;
+
+    return lookup<CommitMeta>("meta:" + commitID, [&](std::size_t &bytes)
+    {
+        std::ifstream in(Repository::objectDir(commitID) + "/meta");
+        if (!in.is_open())
+            return std::shared_ptr<const CommitMeta>();
+
+        auto m = std::make_shared<CommitMeta>();
+        std::string line;
+
+        while (std::getline(in, line))
+        {
+            bytes += line.size();
+            if (line.rfind("commit ", 0) == 0)
+                m->commit = line.substr(7);
+            else if (line.rfind("parent ", 0) == 0)
+            {
+                if (line.substr(7) != "NONE")
+                    m->parents.push_back(line.substr(7));
+            }
+            else if (line.rfind("parent2 ", 0) == 0)
+                m->parents.push_back(line.substr(8));
+            else if (line.rfind("generation ", 0) == 0)
+                m->generation = parseGeneration(line.substr(11));
+            else if (line.rfind("branch ", 0) == 0)
+                m->branch = line.substr(7);
+            else if (line.rfind("message ", 0) == 0)
+                m->message = line.substr(8);
+        }
+
+        bytes += sizeof(CommitMeta);
+        return std::shared_ptr<const CommitMeta>(m);
+    });
+}
+
+void ObjectCache::setBudget(std::size_t bytes)
+{
+    budget() = bytes;
+
+    for (std::size_t i = 0; i < SHARD_COUNT; i++)
+    {
+        std::lock_guard<std::mutex> guard(shards()[i].lock);
+        evict(shards()[i]);
+    }
+}
+
+// Drops every entry. Entries are keyed by relative paths, so anything
+// that switches to another repository in-process (the tests) must call it.
+void ObjectCache::clear()
+{
+    for (std::size_t i = 0; i < SHARD_COUNT; i++)
+    {
+        std::lock_guard<std::mutex> guard(shards()[i].lock);
+        shards()[i].entries.clear();
+        shards()[i].lru.clear();
+        shards()[i].bytes = 0;
+    }
+}
+
+CacheStats ObjectCache::stats()
+{
+    CacheStats st;
+    st.hits = hitCount;
+    st.misses = missCount;
+    st.evictions = evictCount;
+    st.budget = budget();
+
+    for (std::size_t i = 0; i < SHARD_COUNT; i++)
+    {
+        std::lock_guard<std::mutex> guard(shards()[i].lock);
+        st.bytes += shards()[i].bytes;
+    }
+
+    return st;
+}
+
+void ObjectCache::printStats()
+{
+    CacheStats st = stats();
+    std::cerr << "object cache: " << st.hits << " hits, " << st.misses << " misses, "
+              << st.evictions << " evictions, " << st.bytes << "/" << st.budget << " bytes\n";
+}
@@ -0,0 +1,76 @@
+/*
+Object cache = one in-process LRU for everything read from
+.mygit/objects during a command.
+Snapshots and meta never change once written, so an entry stays
+valid for the life of the process; only the byte budget evicts.
+    blob(path)   -> file contents (mmap-backed view when large)
+    lines(path)  -> file split into lines (what diff/merge use); read
+                    separately, so the bytes are not cached twice
+    meta(commit) -> parsed meta file
+Budget: MYGIT_CACHE_BYTES (default 256 MiB).
+MYGIT_CACHE_STATS=1 prints hit/miss counters on exit.
+Never use it for working-tree files; those can change under us.
+*/
+#ifndef OBJECTCACHE_H
+#define OBJECTCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Read-only view over file bytes; either owns a copy or a mapping.
+class Blob
+{
+public:
+    Blob(std::string bytes);
+    Blob(const char *mapped, std::size_t size);
+    ~Blob();
+
+    Blob(const Blob &) = delete;
+    Blob &operator=(const Blob &) = delete;
+
+    const char *data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool mapped() const { return mapped_; }
+
+private:
+    std::string owned_;
+    const char *data_;
+    std::size_t size_;
+    bool mapped_;
+};
+
+struct CommitMeta
+{
+    std::string commit;
+    std::vector<std::string> parents; // first parent, then parent2
+    std::string branch;
+    std::string message;
+    unsigned long generation = 0;     // 0 if meta predates generations
+};
+
+struct CacheStats
+{
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::size_t bytes = 0;
+    std::size_t budget = 0;
+};
+
+class ObjectCache
+{
+public:
+    static std::shared_ptr<const Blob> blob(const std::string &path);
+    static std::shared_ptr<const std::vector<std::string>> lines(const std::string &path);
+    static std::shared_ptr<const CommitMeta> meta(const std::string &commitID);
+
+    static void setBudget(std::size_t bytes);
+    static void clear();
+    static CacheStats stats();
+    static void printStats();
+};
+
+#endif
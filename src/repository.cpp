@@ -1,4 +1,5 @@
 #include "repository.h"
+#include "repostate.h"
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -40,3 +41,31 @@ void Repository::init()
 
     std::cout << "Initialized empty repository.\n";
 }
+
+/*
+ * @brief Directory of a commit in the object store.
+ *
+ * Shared clones keep no objects of their own history; the file
+ * .mygit/objects/alternates lists other objects directories (one
+ * absolute path per line) that are searched after the local one.
+ *
+ * @param commitID The commit.
+ * @return The directory holding meta, manifest and files/; the local
+ *         path if the commit exists nowhere.
+ */
+std::string Repository::objectDir(const std::string &commitID)
+{
+    std::string local = ".mygit/objects/" + commitID;
+    if (fs::is_directory(local))
+        return local;
+
+    auto alternates = RepoState::lines(".mygit/objects/alternates");
+    for (auto &alt : *alternates)
+    {
+        fs::path dir = fs::path(alt) / commitID;
+        if (!alt.empty() && fs::is_directory(dir))
+            return dir.string();
+    }
+
+    return local;
+}
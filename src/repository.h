@@ -8,6 +8,9 @@ class Repository
 public:
     static bool exists(); // Static functions call without creating object.
     static void init();
+
+    // .mygit/objects/<commit>, or where .mygit/objects/alternates finds it.
+    static std::string objectDir(const std::string &commitID);
 };
 
 #endif
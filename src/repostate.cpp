@@ -0,0 +1,86 @@
+#include "repostate.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+// A cached file is trusted only if it had not been touched for this long
+// when it was read (covers coarse filesystem timestamps).
+static const auto RACY_WINDOW = std::chrono::seconds(2);
+
+struct StateEntry
+{
+    fs::file_time_type mtime;
+    std::uintmax_t size;
+    fs::file_time_type loadedAt;
+    std::shared_ptr<const std::vector<std::string>> lines;
+};
+
+static std::unordered_map<std::string, StateEntry> entries;
+static unsigned long commandEpoch = 0;
+
+/*
+ * @brief Lines of a small repository state file.
+ *
+ * @param path Path such as ".mygit/HEAD".
+ * @return The file's lines as std::getline would produce them;
+ *         empty if the file does not exist.
+ */
+std::shared_ptr<const std::vector<std::string>> RepoState::lines(const std::string &path)
+{
+    std::error_code ec;
+    auto mtime = fs::last_write_time(path, ec);
+    auto size = ec ? 0 : fs::file_size(path, ec);
+
+    if (ec)
+    {
+        // One shared empty vector, so a missing file never hands out a
+        // pointer that only the caller's temporary keeps alive.
+        static const auto none = std::make_shared<const std::vector<std::string>>();
+        entries.erase(path);
+        return none;
+    }
+
+    auto it = entries.find(path);
+    if (it != entries.end() && it->second.mtime == mtime && it->second.size == size &&
+        it->second.loadedAt - mtime > RACY_WINDOW)
+    {
+        return it->second.lines;
+    }
+
+    auto loadedAt = fs::file_time_type::clock::now();
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream content;
+    content << in.rdbuf();
+
+    auto result = std::make_shared<std::vector<std::string>>();
+    std::istringstream ss(content.str());
+    std::string line;
+
+    while (std::getline(ss, line))
+        result->push_back(line);
+
+    entries[path] = {mtime, size, loadedAt, result};
+    return result;
+}
+
+std::string RepoState::firstLine(const std::string &path)
+{
+    auto l = lines(path);
+    return l->empty() ? "" : l->front();
+}
+
+// Called once per command; lets derived state (e.g. the sparse set)
+// know when to revalidate.
+void RepoState::beginCommand()
+{
+    commandEpoch++;
+}
+
+unsigned long RepoState::epoch()
+{
+    return commandEpoch;
+}
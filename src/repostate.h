@@ -0,0 +1,29 @@
+/*
+RepoState = in-memory copy of the small mutable files
+(.mygit/HEAD, .mygit/branches/<b>, .mygit/index, ...).
+Each read compares the file's size and mtime with what was cached
+and re-reads only if they differ. Files modified within the last
+couple of seconds are always re-read, because a rewrite in the same
+timestamp tick with the same size would otherwise go unnoticed.
+They are not fingerprinted first: a fingerprint needs the whole file
+read anyway, and for these few-byte files that read is the entire cost.
+Matters for --batch / --serve, where one process runs many commands.
+*/
+#ifndef REPOSTATE_H
+#define REPOSTATE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class RepoState
+{
+public:
+    static std::shared_ptr<const std::vector<std::string>> lines(const std::string &path);
+    static std::string firstLine(const std::string &path);
+
+    static void beginCommand();
+    static unsigned long epoch();
+};
+
+#endif
@@ -0,0 +1,277 @@
+#include "sparse.h"
+#include "repostate.h"
+#include "manifest.h"
+#include "materialize.h"
+#include "repository.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+static const std::string SPARSE_PATH = ".mygit/sparse-checkout";
+
+static bool loaded = false;
+static unsigned long loadedEpoch = 0;
+static bool active = false;
+static std::vector<std::string> cones;
+
+static std::string getCurrentBranch()
+{
+    std::string ref = RepoState::firstLine(".mygit/HEAD");
+    return ref.substr(ref.find_last_of('/') + 1);
+}
+
+static std::string getBranchHeadCommit(const std::string &branch)
+{
+    std::string commit = RepoState::firstLine(".mygit/branches/" + branch);
+    return commit.empty() ? "NONE" : commit;
+}
+
+static bool indexIsEmpty()
+{
+    return RepoState::lines(".mygit/index")->empty();
+}
+
+/*
+ * @brief Normalize a cone pattern.
+ *
+ * Patterns are stored like index paths: relative, forward slashes,
+ * no leading "./" and no trailing "/".
+ */
+static std::string normalizePattern(std::string p)
+{
+    for (auto &c : p)
+        if (c == '\\')
+            c = '/';
+    while (p.rfind("./", 0) == 0)
+        p = p.substr(2);
+    while (!p.empty() && p.back() == '/')
+        p.pop_back();
+    return p;
+}
+
+// Reloaded at most once per command, so a long-running --batch process
+// sees changes made by other processes between commands.
+static void load()
+{
+    if (loaded && loadedEpoch == RepoState::epoch())
+        return;
+    loaded = true;
+    loadedEpoch = RepoState::epoch();
+
+    cones.clear();
+    active = fs::exists(SPARSE_PATH);
+
+    auto patterns = RepoState::lines(SPARSE_PATH);
+    for (auto line : *patterns)
+    {
+        line = normalizePattern(line);
+        if (!line.empty())
+            cones.push_back(line);
+    }
+}
+
+static bool isUnder(const std::string &path, const std::string &dir)
+{
+    return path.size() > dir.size() && path.compare(0, dir.size(), dir) == 0 && path[dir.size()] == '/';
+}
+
+bool Sparse::enabled()
+{
+    load();
+    return active;
+}
+
+/*
+ * @brief Check whether a file belongs to the sparse set.
+ *
+ * @param path Normalized relative path of a file.
+ * @return true if sparse checkout is off, the file is in the root,
+ *         or it lies at/below one of the cone directories.
+ */
+bool Sparse::includes(const std::string &path)
+{
+    if (!enabled() || path.find('/') == std::string::npos)
+        return true;
+
+    for (auto &c : cones)
+        if (path == c || isUnder(path, c))
+            return true;
+    return false;
+}
+
+/*
+ * @brief Check whether a directory has to be descended into.
+ *
+ * @param dir Normalized relative directory path.
+ * @return true if the directory is inside a cone or is an ancestor
+ *         of one; false means the whole subtree can be skipped.
+ */
+bool Sparse::includesDir(const std::string &dir)
+{
+    if (!enabled() || dir.empty() || dir == ".")
+        return true;
+
+    for (auto &c : cones)
+        if (dir == c || isUnder(dir, c) || isUnder(c, dir))
+            return true;
+    return false;
+}
+
+// Remove now-empty parent directories of a removed working-tree file.
+static void pruneEmptyParents(fs::path p)
+{
+    p = p.parent_path();
+    while (!p.empty() && fs::is_directory(p) && fs::is_empty(p))
+    {
+        fs::remove(p);
+        p = p.parent_path();
+    }
+}
+
+/*
+ * @brief Files the sparse set would remove that differ from the commit.
+ *
+ * Size is compared first; only same-size files are hashed.
+ */
+static std::vector<std::string> modifiedOutsideSet(const std::string &commit)
+{
+    std::vector<std::string> dirty;
+
+    for (auto &[path, e] : Manifest::load(commit))
+    {
+        std::error_code ec;
+        auto size = fs::file_size(path, ec);
+
+        if (ec || Sparse::includes(path))
+            continue;
+
+        if (size != e.size || Manifest::hashFile(path, e.hash.size() == 16) != e.hash)
+            dirty.push_back(path);
+    }
+
+    return dirty;
+}
+
+/*
+ * @brief Bring the working tree in line with the sparse set.
+ *
+ * Files of the current commit that left the set are removed, files
+ * that entered it are restored from the snapshot.
+ */
+static void applyToWorkingTree()
+{
+    std::string commit = getBranchHeadCommit(getCurrentBranch());
+    if (commit == "NONE")
+        return;
+
+    fs::path filesPath = Repository::objectDir(commit) + "/files";
+    int added = 0, removed = 0;
+
+    for (auto &[path, e] : Manifest::load(commit))
+    {
+        bool want = Sparse::includes(path);
+        bool have = fs::exists(path);
+
+        if (want && !have)
+        {
+            Materialize::file(filesPath / path, path);
+            added++;
+        }
+        else if (!want && have)
+        {
+            fs::remove(path);
+            pruneEmptyParents(path);
+            removed++;
+        }
+    }
+
+    std::cout << "Restored " << added << " file(s), removed " << removed << " file(s).\n";
+}
+
+void Sparse::set(const std::vector<std::string> &patterns, bool force)
+{
+    if (!Repository::exists())
+    {
+        std::cout << "Not a mygit repository.\n";
+        return;
+    }
+
+    if (!indexIsEmpty())
+    {
+        std::cout << "You have staged changes. Commit or clear them before changing the sparse set.\n";
+        return;
+    }
+
+    load();
+    std::vector<std::string> oldCones = cones;
+    bool wasActive = active;
+
+    cones.clear();
+    for (auto &p : patterns)
+    {
+        std::string n = normalizePattern(p);
+        if (!n.empty())
+            cones.push_back(n);
+    }
+    active = true;
+
+    // Local edits in files that leave the set would be deleted with them.
+    std::string commit = getBranchHeadCommit(getCurrentBranch());
+    if (!force && commit != "NONE")
+    {
+        auto dirty = modifiedOutsideSet(commit);
+        if (!dirty.empty())
+        {
+            cones = oldCones;
+            active = wasActive;
+
+            std::cout << "The following files have local changes and would be removed:\n";
+            for (auto &path : dirty)
+                std::cout << "  " << path << "\n";
+            std::cout << "Commit or revert them, or use 'sparse-checkout set --force' to discard them.\n";
+            return;
+        }
+    }
+
+    std::ofstream out(SPARSE_PATH, std::ios::trunc);
+    for (auto &c : cones)
+        out << c << "\n";
+    out.close();
+
+    applyToWorkingTree();
+}
+
+void Sparse::list()
+{
+    if (!enabled())
+    {
+        std::cout << "Sparse checkout is not enabled.\n";
+        return;
+    }
+
+    for (auto &c : cones)
+        std::cout << c << "/\n";
+}
+
+void Sparse::disable()
+{
+    if (!Repository::exists())
+    {
+        std::cout << "Not a mygit repository.\n";
+        return;
+    }
+
+    if (!enabled())
+    {
+        std::cout << "Sparse checkout is not enabled.\n";
+        return;
+    }
+
+    fs::remove(SPARSE_PATH);
+    cones.clear();
+    active = false;
+
+    applyToWorkingTree();
+}
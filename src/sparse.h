@@ -0,0 +1,30 @@
+/*
+Sparse checkout (cone mode):
+.mygit/sparse-checkout holds one directory per line.
+When the file exists, only these paths are materialized/staged:
+    - files directly in the repository root
+    - files at or below one of the listed directories
+Directories that are neither inside a listed directory nor on the
+way to one are skipped without being enumerated.
+No file (or "disable") = full checkout.
+"set" refuses to remove files with local changes unless forced.
+*/
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include <string>
+#include <vector>
+
+class Sparse
+{
+public:
+    static void set(const std::vector<std::string> &patterns, bool force = false);
+    static void list();
+    static void disable();
+
+    static bool enabled();
+    static bool includes(const std::string &path);
+    static bool includesDir(const std::string &dir);
+};
+
+#endif
@@ -1,14 +1,14 @@
 #include "status.h"
+#include "repostate.h"
 #include "repository.h"
+#include "sparse.h"
 #include <fstream>
 #include <iostream>
 #include <string>
 
 static std::string getCurrentBranch()
 {
-    std::ifstream head(".mygit/HEAD");
-    std::string ref;
-    std::getline(head, ref);
+    std::string ref = RepoState::firstLine(".mygit/HEAD");
 
     // ref format: refs/branches/<branch>
     auto pos = ref.find_last_of('/');
@@ -19,11 +19,10 @@ static std::string getCurrentBranch()
 
 static void showStagedFiles()
 {
-    std::ifstream index(".mygit/index");
-    std::string line;
     bool empty = true;
 
-    while (std::getline(index, line))
+    auto index = RepoState::lines(".mygit/index");
+    for (const auto &line : *index)
     {
         if (line.empty())
             continue;
@@ -51,7 +50,10 @@ void Status::show()
 
     std::string branch = getCurrentBranch();
 
-    std::cout << "On branch " << branch << "\n\n";
+    std::cout << "On branch " << branch << "\n";
+    if (Sparse::enabled())
+        std::cout << "Sparse checkout is enabled (see 'mygit sparse-checkout list').\n";
+    std::cout << "\n";
 
     showStagedFiles();
 }
@@ -0,0 +1,174 @@
+#include "uring.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define MYGIT_URING 1
+#include <cerrno>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef MYGIT_URING
+
+static unsigned *at(void *base, unsigned offset)
+{
+    return reinterpret_cast<unsigned *>(static_cast<char *>(base) + offset);
+}
+
+Uring::Uring(unsigned entries)
+{
+    io_uring_params p;
+    std::memset(&p, 0, sizeof(p));
+
+    int fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (fd < 0)
+        return;
+
+    sqRingSize_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqRingSize_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    sqesSize_ = p.sq_entries * sizeof(io_uring_sqe);
+
+    // Since 5.4 both rings live in one mapping.
+    bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (single)
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+
+    sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   fd, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED)
+    {
+        sqRing_ = nullptr;
+        close(fd);
+        return;
+    }
+
+    cqRing_ = single ? sqRing_
+                     : mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            fd, IORING_OFF_CQ_RING);
+    sqes_ = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                 fd, IORING_OFF_SQES);
+
+    if (cqRing_ == MAP_FAILED || sqes_ == MAP_FAILED)
+    {
+        if (cqRing_ != MAP_FAILED && !single)
+            munmap(cqRing_, cqRingSize_);
+        if (sqes_ != MAP_FAILED)
+            munmap(sqes_, sqesSize_);
+        munmap(sqRing_, sqRingSize_);
+        sqRing_ = cqRing_ = sqes_ = nullptr;
+        close(fd);
+        return;
+    }
+
+    sqHead_ = at(sqRing_, p.sq_off.head);
+    sqTail_ = at(sqRing_, p.sq_off.tail);
+    sqMask_ = at(sqRing_, p.sq_off.ring_mask);
+    sqArray_ = at(sqRing_, p.sq_off.array);
+    cqHead_ = at(cqRing_, p.cq_off.head);
+    cqTail_ = at(cqRing_, p.cq_off.tail);
+    cqMask_ = at(cqRing_, p.cq_off.ring_mask);
+    cqes_ = static_cast<char *>(cqRing_) + p.cq_off.cqes;
+    sqEntries_ = p.sq_entries;
+    fd_ = fd;
+
+    // Opcode support (5.6+); on older kernels nothing reports as supported.
+    std::vector<char> buf(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+    auto *probe = reinterpret_cast<io_uring_probe *>(buf.data());
+    if (syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE, probe, 256) == 0)
+    {
+        for (unsigned i = 0; i < probe->ops_len && i < 256; i++)
+            probe_[probe->ops[i].op] = probe->ops[i].flags & IO_URING_OP_SUPPORTED;
+    }
+}
+
+Uring::~Uring()
+{
+    if (fd_ < 0)
+        return;
+
+    munmap(sqes_, sqesSize_);
+    if (cqRing_ != sqRing_)
+        munmap(cqRing_, cqRingSize_);
+    munmap(sqRing_, sqRingSize_);
+    close(fd_);
+}
+
+bool Uring::supports(unsigned char op) const
+{
+    return fd_ >= 0 && probe_[op];
+}
+
+io_uring_sqe *Uring::sqe()
+{
+    unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    unsigned tail = *sqTail_;
+
+    if (tail - head >= sqEntries_)
+        return nullptr;
+
+    unsigned index = tail & *sqMask_;
+    io_uring_sqe *e = static_cast<io_uring_sqe *>(sqes_) + index;
+    std::memset(e, 0, sizeof(*e));
+    sqArray_[index] = index;
+
+    __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+    pending_++;
+    return e;
+}
+
+/*
+ * @brief Hand queued entries to the kernel and wait for completions.
+ *
+ * @return 0, or -errno if io_uring_enter failed for good.
+ */
+int Uring::submitAndWait(unsigned waitFor)
+{
+    for (;;)
+    {
+        int r = syscall(__NR_io_uring_enter, fd_, pending_, waitFor, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+        if (r >= 0)
+        {
+            pending_ -= std::min<unsigned>(pending_, r);
+            return 0;
+        }
+        if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            return -errno;
+    }
+}
+
+unsigned Uring::reap(const std::function<void(std::uint64_t, int)> &fn)
+{
+    unsigned head = *cqHead_, count = 0;
+    unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+
+    while (head != tail)
+    {
+        io_uring_cqe *c = static_cast<io_uring_cqe *>(cqes_) + (head & *cqMask_);
+        std::uint64_t data = c->user_data;
+        int res = c->res;
+
+        __atomic_store_n(cqHead_, ++head, __ATOMIC_RELEASE);
+        count++;
+        fn(data, res);
+
+        tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    }
+
+    return count;
+}
+
+#else
+
+Uring::Uring(unsigned) {}
+Uring::~Uring() {}
+bool Uring::supports(unsigned char) const { return false; }
+io_uring_sqe *Uring::sqe() { return nullptr; }
+int Uring::submitAndWait(unsigned) { return -1; }
+unsigned Uring::reap(const std::function<void(std::uint64_t, int)> &) { return 0; }
+
+#endif
@@ -0,0 +1,49 @@
+/*
+Uring = minimal io_uring ring on raw syscalls (no liburing).
+    Uring ring(entries);      io_uring_setup + mmap of SQ/CQ/SQE arrays
+    ring.ok()                 false if the kernel refused (old kernel,
+                              seccomp, io_uring_disabled sysctl)
+    ring.supports(op)         from IORING_REGISTER_PROBE
+    ring.sqe()                next free submission entry, zeroed; null
+                              when the queue is full
+    ring.submitAndWait(n)     submit queued entries, wait for n completions
+    ring.reap(fn)             fn(user_data, res) for every completion
+One thread owns a ring; nothing here is synchronized.
+*/
+#ifndef URING_H
+#define URING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+struct io_uring_sqe;
+
+class Uring
+{
+public:
+    explicit Uring(unsigned entries);
+    ~Uring();
+    Uring(const Uring &) = delete;
+    Uring &operator=(const Uring &) = delete;
+
+    bool ok() const { return fd_ >= 0; }
+    bool supports(unsigned char op) const;
+
+    io_uring_sqe *sqe();
+    int submitAndWait(unsigned waitFor);
+    unsigned reap(const std::function<void(std::uint64_t, int)> &fn);
+
+private:
+    int fd_ = -1;
+    void *sqRing_ = nullptr, *cqRing_ = nullptr, *sqes_ = nullptr;
+    std::size_t sqRingSize_ = 0, cqRingSize_ = 0, sqesSize_ = 0;
+
+    unsigned *sqHead_ = nullptr, *sqTail_ = nullptr, *sqMask_ = nullptr, *sqArray_ = nullptr;
+    unsigned *cqHead_ = nullptr, *cqTail_ = nullptr, *cqMask_ = nullptr;
+    void *cqes_ = nullptr;
+    unsigned sqEntries_ = 0, pending_ = 0;
+    unsigned char probe_[256] = {};
+};
+
+#endif
@@ -0,0 +1,172 @@
+#include "worktree.h"
+#include "repostate.h"
+#include "materialize.h"
+#include "repository.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static std::string readHeadBranch(const fs::path &gitDir)
+{
+    std::string ref = RepoState::firstLine((gitDir / "HEAD").string());
+    return ref.substr(ref.find_last_of('/') + 1);
+}
+
+static std::string getBranchHeadCommit(const std::string &branch)
+{
+    std::string commit = RepoState::firstLine(".mygit/branches/" + branch);
+    return commit.empty() ? "NONE" : commit;
+}
+
+// The .mygit of the main repository, also when called from inside a worktree.
+static fs::path mainGitDir()
+{
+    return fs::canonical(".mygit/objects").parent_path();
+}
+
+// (worktree path, its .mygit) for the main repository and every registered worktree.
+static std::vector<std::pair<fs::path, fs::path>> allWorktrees()
+{
+    fs::path main = mainGitDir();
+    std::vector<std::pair<fs::path, fs::path>> result{{main.parent_path(), main}};
+
+    if (!fs::exists(main / "worktrees"))
+        return result;
+
+    for (auto &entry : fs::directory_iterator(main / "worktrees"))
+    {
+        std::ifstream in(entry.path());
+        std::string path;
+        std::getline(in, path);
+
+        if (fs::exists(fs::path(path) / ".mygit" / "HEAD"))
+            result.push_back({path, fs::path(path) / ".mygit"});
+    }
+
+    return result;
+}
+
+/*
+ * @brief Find another worktree that has a branch checked out.
+ *
+ * @param branch Branch name.
+ * @return Path of that worktree, or empty if none (the current
+ *         worktree is not counted).
+ */
+std::string Worktree::checkedOutElsewhere(const std::string &branch)
+{
+    fs::path self = fs::canonical(".mygit");
+
+    for (auto &[path, gitDir] : allWorktrees())
+    {
+        if (fs::canonical(gitDir) != self && readHeadBranch(gitDir) == branch)
+            return path.string();
+    }
+
+    return "";
+}
+
+void Worktree::add(const std::string &dir, const std::string &branch)
+{
+    if (!Repository::exists())
+    {
+        std::cout << "Not a mygit repository.\n";
+        return;
+    }
+
+    if (!fs::exists(".mygit/branches/" + branch))
+    {
+        std::cout << "Branch '" << branch << "' does not exist.\n";
+        return;
+    }
+
+    if (fs::exists(dir) && !(fs::is_directory(dir) && fs::is_empty(dir)))
+    {
+        std::cout << "'" << dir << "' already exists and is not an empty directory.\n";
+        return;
+    }
+
+    for (auto &[path, gitDir] : allWorktrees())
+    {
+        if (readHeadBranch(gitDir) == branch)
+        {
+            std::cout << "Branch '" << branch << "' is already checked out at " << path.string() << "\n";
+            return;
+        }
+    }
+
+    fs::path main = mainGitDir();
+    fs::path root = fs::absolute(dir).lexically_normal();
+    fs::path gitDir = root / ".mygit";
+
+    fs::create_directories(gitDir);
+
+    std::error_code ec;
+    for (const char *shared : {"objects", "branches", "logs"})
+    {
+        fs::create_directory_symlink(main / shared, gitDir / shared, ec);
+        if (ec)
+        {
+            std::cout << "Cannot link shared store: " << ec.message() << "\n";
+            fs::remove_all(gitDir);
+            return;
+        }
+    }
+
+    std::ofstream head(gitDir / "HEAD");
+    head << "ref: refs/branches/" << branch;
+    head.close();
+
+    std::ofstream index(gitDir / "index");
+    index.close();
+
+    // Register with the main repository
+    fs::create_directories(main / "worktrees");
+    std::string name = root.filename().string();
+    std::string unique = name;
+    for (int n = 1; fs::exists(main / "worktrees" / unique); n++)
+        unique = name + std::to_string(n);
+
+    std::ofstream reg(main / "worktrees" / unique);
+    reg << root.string();
+    reg.close();
+
+    // Materialize the branch head
+    std::string commit = getBranchHeadCommit(branch);
+    int count = 0;
+    fs::path filesPath = Repository::objectDir(commit) + "/files";
+
+    if (commit != "NONE" && fs::exists(filesPath))
+    {
+        std::vector<CopyJob> jobs;
+        for (auto &entry : fs::recursive_directory_iterator(filesPath))
+        {
+            if (entry.is_regular_file())
+                jobs.push_back({entry.path(), root / fs::relative(entry.path(), filesPath)});
+        }
+
+        Materialize::files(jobs);
+        count = jobs.size();
+    }
+
+    std::cout << "Worktree '" << dir << "' on branch '" << branch << "' (" << count << " files)\n";
+}
+
+void Worktree::list()
+{
+    if (!Repository::exists())
+    {
+        std::cout << "Not a mygit repository.\n";
+        return;
+    }
+
+    for (auto &[path, gitDir] : allWorktrees())
+    {
+        std::cout << path.string() << "  [" << readHeadBranch(gitDir) << "]\n";
+    }
+}
@@ -0,0 +1,27 @@
+/*
+Worktree = extra working directory on the same object store.
+<dir>/.mygit/
+├── HEAD        (own)
+├── index       (own)
+├── objects  -> <main>/.mygit/objects   (symlink, shared)
+├── branches -> <main>/.mygit/branches  (symlink, shared)
+└── logs     -> <main>/.mygit/logs      (symlink, shared)
+The main repository lists its worktrees in
+<main>/.mygit/worktrees/<name> (content: absolute worktree path).
+A branch can be checked out in only one worktree at a time, so each
+worktree commits to its own branch file and never races another.
+*/
+#ifndef WORKTREE_H
+#define WORKTREE_H
+
+#include <string>
+
+class Worktree
+{
+public:
+    static void add(const std::string &dir, const std::string &branch);
+    static void list();
+    static std::string checkedOutElsewhere(const std::string &branch);
+};
+
+#endif
@@ -0,0 +1,371 @@
+#include "zstd.h"
+#include "hash.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+static const std::size_t BLOCK_MAX = 128 * 1024;
+static const int HASH_BITS = 16;
+static const int MIN_MATCH = 4;
+static const std::uint32_t NO_POS = UINT32_MAX;
+
+// ---- predefined FSE distributions (RFC 8878, 3.1.1.3.2.2) ----
+
+static const short LL_NORM[36] = {4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2, 2,
+                                  2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1, -1, -1, -1, -1};
+static const short ML_NORM[53] = {1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+                                  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+                                  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1, -1, -1};
+static const short OF_NORM[29] = {1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1,
+                                  1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1};
+
+static const std::uint32_t LL_BASE[36] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                                          16, 18, 20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512,
+                                          1024, 2048, 4096, 8192, 16384, 32768, 65536};
+static const int LL_BITS[36] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+
+static const std::uint32_t ML_BASE[53] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+                                          19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+                                          35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515,
+                                          1027, 2051, 4099, 8195, 16387, 32771, 65539};
+static const int ML_BITS[53] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1,
+                                2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+
+static int highBit(std::uint32_t v)
+{
+    int n = 0;
+    while (v >>= 1)
+        n++;
+    return n;
+}
+
+/*
+ * FSE table as the decoder sees it. The encoder walks it backwards:
+ * cover[s][next] is the state of symbol s whose transition range
+ * [baseline, baseline + 2^nbBits) contains the following state.
+ */
+struct FseTable
+{
+    struct Cell
+    {
+        int symbol, nbBits;
+        std::uint32_t baseline;
+    };
+
+    int log;
+    std::vector<Cell> cells;
+    std::vector<std::vector<std::uint16_t>> cover;
+
+    FseTable(const short *norm, int symbols, int tableLog) : log(tableLog)
+    {
+        std::uint32_t size = 1u << log;
+        std::uint32_t high = size - 1;
+        std::vector<std::uint32_t> next(symbols);
+        cells.resize(size);
+
+        for (int s = 0; s < symbols; s++)
+        {
+            if (norm[s] == -1)
+            {
+                cells[high--].symbol = s;
+                next[s] = 1;
+            }
+            else
+                next[s] = norm[s];
+        }
+
+        std::uint32_t pos = 0, step = (size >> 1) + (size >> 3) + 3;
+        for (int s = 0; s < symbols; s++)
+        {
+            for (int i = 0; i < norm[s]; i++)
+            {
+                cells[pos].symbol = s;
+                do
+                    pos = (pos + step) & (size - 1);
+                while (pos > high);
+            }
+        }
+
+        cover.assign(symbols, std::vector<std::uint16_t>(size));
+        for (std::uint32_t u = 0; u < size; u++)
+        {
+            Cell &c = cells[u];
+            std::uint32_t n = next[c.symbol]++;
+            c.nbBits = log - highBit(n);
+            c.baseline = (n << c.nbBits) - size;
+
+            for (std::uint32_t t = c.baseline; t < c.baseline + (1u << c.nbBits); t++)
+                cover[c.symbol][t] = u;
+        }
+    }
+
+    std::uint32_t firstState(int symbol) const
+    {
+        for (std::uint32_t u = 0; u < cells.size(); u++)
+            if (cells[u].symbol == symbol)
+                return u;
+        return 0;
+    }
+};
+
+static const FseTable &llTable()
+{
+    static const FseTable t(LL_NORM, 36, 6);
+    return t;
+}
+
+static const FseTable &mlTable()
+{
+    static const FseTable t(ML_NORM, 53, 6);
+    return t;
+}
+
+static const FseTable &ofTable()
+{
+    static const FseTable t(OF_NORM, 29, 5);
+    return t;
+}
+
+// Forward bit writer; the decoder reads the result from the end backwards.
+struct BitWriter
+{
+    std::string out;
+    std::uint64_t acc = 0;
+    int count = 0;
+
+    void add(std::uint64_t value, int bits)
+    {
+        acc |= (value & ((1ULL << bits) - 1)) << count;
+        count += bits;
+        while (count >= 8)
+        {
+            out += static_cast<char>(acc & 0xFF);
+            acc >>= 8;
+            count -= 8;
+        }
+    }
+
+    void close()
+    {
+        add(1, 1);
+        if (count > 0)
+            out += static_cast<char>(acc & 0xFF);
+    }
+};
+
+struct Sequence
+{
+    std::uint32_t literals, match, offset;
+};
+
+struct Code
+{
+    int code, bits;
+    std::uint32_t extra;
+};
+
+static Code codeFor(std::uint32_t value, const std::uint32_t *base, const int *bits, int count)
+{
+    int c = count - 1;
+    while (base[c] > value)
+        c--;
+    return {c, bits[c], value - base[c]};
+}
+
+static void put24(std::string &out, std::uint32_t v)
+{
+    out += static_cast<char>(v & 0xFF);
+    out += static_cast<char>((v >> 8) & 0xFF);
+    out += static_cast<char>((v >> 16) & 0xFF);
+}
+
+static void put32(std::string &out, std::uint32_t v)
+{
+    put24(out, v);
+    out += static_cast<char>(v >> 24);
+}
+
+static void encodeState(BitWriter &bw, const FseTable &t, int symbol, std::uint32_t &state)
+{
+    std::uint32_t cell = t.cover[symbol][state];
+    bw.add(state - t.cells[cell].baseline, t.cells[cell].nbBits);
+    state = cell;
+}
+
+/*
+ * @brief Body of a compressed block: literals section + sequences section.
+ */
+static std::string encodeBlock(const std::string &literals, const std::vector<Sequence> &seqs)
+{
+    std::string out;
+
+    // Raw literals, 3-byte header (20-bit size)
+    std::uint32_t n = literals.size();
+    out += static_cast<char>((3 << 2) | ((n & 0xF) << 4));
+    out += static_cast<char>((n >> 4) & 0xFF);
+    out += static_cast<char>((n >> 12) & 0xFF);
+    out += literals;
+
+    std::size_t count = seqs.size();
+    if (count < 128)
+        out += static_cast<char>(count);
+    else if (count < 0x7F00)
+    {
+        out += static_cast<char>((count >> 8) + 0x80);
+        out += static_cast<char>(count & 0xFF);
+    }
+    else
+    {
+        out += static_cast<char>(0xFF);
+        out += static_cast<char>((count - 0x7F00) & 0xFF);
+        out += static_cast<char>((count - 0x7F00) >> 8);
+    }
+
+    if (count == 0)
+        return out;
+
+    out += static_cast<char>(0); // predefined mode for all three tables
+
+    std::vector<Code> ll(count), ml(count), of(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        ll[i] = codeFor(seqs[i].literals, LL_BASE, LL_BITS, 36);
+        ml[i] = codeFor(seqs[i].match, ML_BASE, ML_BITS, 53);
+
+        // Offset_Value = offset + 3 keeps clear of the repeat-offset codes
+        std::uint32_t value = seqs[i].offset + 3;
+        int code = highBit(value);
+        of[i] = {code, code, value - (1u << code)};
+    }
+
+    const FseTable &llT = llTable(), &mlT = mlTable(), &ofT = ofTable();
+    BitWriter bw;
+
+    // Written in the reverse of the order the decoder reads.
+    std::size_t last = count - 1;
+    std::uint32_t llState = llT.firstState(ll[last].code);
+    std::uint32_t mlState = mlT.firstState(ml[last].code);
+    std::uint32_t ofState = ofT.firstState(of[last].code);
+
+    bw.add(ll[last].extra, ll[last].bits);
+    bw.add(ml[last].extra, ml[last].bits);
+    bw.add(of[last].extra, of[last].bits);
+
+    for (std::size_t i = last; i-- > 0;)
+    {
+        encodeState(bw, ofT, of[i].code, ofState);
+        encodeState(bw, mlT, ml[i].code, mlState);
+        encodeState(bw, llT, ll[i].code, llState);
+
+        bw.add(ll[i].extra, ll[i].bits);
+        bw.add(ml[i].extra, ml[i].bits);
+        bw.add(of[i].extra, of[i].bits);
+    }
+
+    bw.add(mlState, mlT.log);
+    bw.add(ofState, ofT.log);
+    bw.add(llState, llT.log);
+    bw.close();
+
+    return out + bw.out;
+}
+
+static std::uint32_t read32(const unsigned char *p)
+{
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static std::uint32_t hash4(const unsigned char *p)
+{
+    return (read32(p) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/*
+ * @brief Compress one buffer into a self-contained zstd frame.
+ *
+ * Matches may reach back anywhere in the frame, so callers choose the
+ * frame size (and with it memory use and parallelism).
+ *
+ * @param data The bytes to compress.
+ * @param len Number of bytes; frames larger than 4 GiB are not supported.
+ * @return The frame.
+ */
+std::string Zstd::compressFrame(const char *data, std::size_t len)
+{
+    const unsigned char *src = reinterpret_cast<const unsigned char *>(data);
+    std::string out;
+
+    // Magic, then header: 4-byte content size, single segment, checksum
+    put32(out, 0xFD2FB528);
+    out += static_cast<char>(0xA4);
+    put32(out, static_cast<std::uint32_t>(len));
+
+    std::vector<std::uint32_t> table(1u << HASH_BITS, NO_POS);
+    std::size_t start = 0;
+
+    do
+    {
+        std::size_t end = std::min(start + BLOCK_MAX, len);
+        bool lastBlock = end == len;
+        std::vector<Sequence> seqs;
+        std::string literals;
+
+        std::size_t pos = start, anchor = start;
+        while (end - start >= MIN_MATCH && pos + MIN_MATCH <= end)
+        {
+            std::uint32_t h = hash4(src + pos);
+            std::uint32_t cand = table[h];
+            table[h] = pos;
+
+            if (cand == NO_POS || read32(src + cand) != read32(src + pos))
+            {
+                pos += 1 + ((pos - anchor) >> 6);
+                continue;
+            }
+
+            std::size_t match = MIN_MATCH;
+            while (pos + match < end && src[cand + match] == src[pos + match])
+                match++;
+            while (pos > anchor && cand > 0 && src[cand - 1] == src[pos - 1])
+            {
+                pos--;
+                cand--;
+                match++;
+            }
+
+            literals.append(data + anchor, pos - anchor);
+            seqs.push_back({static_cast<std::uint32_t>(pos - anchor), static_cast<std::uint32_t>(match),
+                            static_cast<std::uint32_t>(pos - cand)});
+
+            pos += match;
+            anchor = pos;
+            if (pos - 2 + MIN_MATCH <= end)
+                table[hash4(src + pos - 2)] = pos - 2;
+        }
+        literals.append(data + anchor, end - anchor);
+
+        std::string body = seqs.empty() ? std::string() : encodeBlock(literals, seqs);
+        std::uint32_t last = lastBlock ? 1 : 0;
+
+        if (!body.empty() && body.size() < end - start)
+        {
+            put24(out, last | (2 << 1) | static_cast<std::uint32_t>(body.size() << 3));
+            out += body;
+        }
+        else
+        {
+            put24(out, last | static_cast<std::uint32_t>((end - start) << 3));
+            out.append(data + start, end - start);
+        }
+
+        start = end;
+    } while (start < len);
+
+    put32(out, static_cast<std::uint32_t>(Hash::fast64(data, len)));
+    return out;
+}
@@ -0,0 +1,22 @@
+/*
+Zstd = minimal Zstandard (RFC 8878) frame encoder, no external library.
+    compressFrame(data, len) -> one complete frame: single segment,
+                                content size and XXH64 checksum set.
+Blocks use greedy LZ matching (hash of 4 bytes, matches anywhere
+earlier in the frame), raw literals and the predefined FSE tables for
+sequences; a block that does not shrink is stored raw. Any zstd
+decoder reads the output; concatenated frames form one stream.
+*/
+#ifndef ZSTD_H
+#define ZSTD_H
+
+#include <cstddef>
+#include <string>
+
+class Zstd
+{
+public:
+    static std::string compressFrame(const char *data, std::size_t len);
+};
+
+#endif
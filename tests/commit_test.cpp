@@ -0,0 +1,29 @@
+#include "test.h"
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+TEST(commit_failure_cleans_up)
+{
+    mygit({"init"});
+    writeFile("f.txt", "1\n");
+    std::string first = commitFiles({"f.txt"}, "first");
+
+    // A staged path that vanished makes the snapshot copy throw.
+    writeFile(".mygit/index", "missing.txt\n");
+    mygit({"commit", "broken"});
+
+    CHECK_EQ(branchHead("main"), first);
+    CHECK(!fs::exists(".mygit/commit.lock"));
+    CHECK_EQ(readFile(".mygit/index"), std::string("missing.txt\n"));
+
+    int snapshots = 0;
+    for (auto &e : fs::directory_iterator(".mygit/objects"))
+        snapshots += e.is_directory();
+    CHECK_EQ(snapshots, 1);
+
+    // The next commit works once the index is fixed.
+    writeFile(".mygit/index", "");
+    writeFile("f.txt", "2\n");
+    CHECK(commitFiles({"f.txt"}, "second") != first);
+}
@@ -0,0 +1,122 @@
+#include "test.h"
+#include "delta.h"
+#include <cstdint>
+#include <stdexcept>
+
+static std::string roundTrip(const std::string &oldData, const std::string &newData)
+{
+    std::string delta = Delta::encode(oldData.data(), oldData.size(), newData.data(), newData.size());
+    return Delta::apply(oldData.data(), oldData.size(), delta);
+}
+
+// Deterministic bytes so failures reproduce.
+static std::string noise(std::uint32_t &seed, std::size_t n)
+{
+    std::string s(n, '\0');
+    for (auto &c : s)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        c = static_cast<char>(seed >> 24);
+    }
+    return s;
+}
+
+TEST(delta_edge_cases)
+{
+    std::string text = "the quick brown fox jumps over the lazy dog\n";
+    CHECK_EQ(roundTrip("", ""), std::string());
+    CHECK_EQ(roundTrip("", text), text);
+    CHECK_EQ(roundTrip(text, ""), std::string());
+    CHECK_EQ(roundTrip(text, text), text);
+}
+
+TEST(delta_edits)
+{
+    std::uint32_t seed = 1;
+    std::string old = noise(seed, 64 * 1024);
+
+    std::string middle = old;
+    middle.replace(30000, 100, noise(seed, 250));
+    CHECK(roundTrip(old, middle) == middle);
+
+    std::string front = noise(seed, 77) + old;
+    CHECK(roundTrip(old, front) == front);
+
+    std::string cut = old.substr(0, 20000) + old.substr(40000);
+    CHECK(roundTrip(old, cut) == cut);
+}
+
+TEST(delta_fuzz)
+{
+    std::uint32_t seed = 42;
+    for (int i = 0; i < 200; i++)
+    {
+        std::size_t size = noise(seed, 1)[0] & 0xff;
+        std::string old = noise(seed, size * 37);
+        std::string next = old;
+
+        // A few random splices of fresh bytes or repeated old ranges.
+        int edits = 1 + (static_cast<unsigned char>(noise(seed, 1)[0]) % 4);
+        for (int e = 0; e < edits; e++)
+        {
+            std::size_t at = next.empty() ? 0 : seed % (next.size() + 1);
+            std::size_t drop = std::min<std::size_t>(next.size() - at, (seed >> 8) % 64);
+            std::string insert = (seed & 1) ? noise(seed, (seed >> 16) % 48)
+                                            : old.substr(0, std::min<std::size_t>(old.size(), 40));
+            next.replace(at, drop, insert);
+            noise(seed, 1);
+        }
+
+        if (roundTrip(old, next) != next)
+        {
+            CHECK(!"round trip mismatch");
+            return;
+        }
+    }
+}
+
+TEST(delta_rejects_wrong_base)
+{
+    std::uint32_t seed = 7;
+    std::string old = noise(seed, 4096), next = old + "tail";
+    std::string delta = Delta::encode(old.data(), old.size(), next.data(), next.size());
+
+    std::string other = old;
+    other[100] ^= 1;
+    bool threw = false;
+    try
+    {
+        Delta::apply(other.data(), other.size(), delta);
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+
+    threw = false;
+    try
+    {
+        Delta::apply(old.data(), old.size(), delta.substr(0, delta.size() - 2));
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+TEST(delta_is_small_for_small_change)
+{
+    std::uint32_t seed = 9;
+    std::string old = noise(seed, 1 << 20), next = old;
+    next[500000] ^= 0x55;
+
+    std::string delta = Delta::encode(old.data(), old.size(), next.data(), next.size());
+    CHECK(delta.size() < 256);
+    CHECK(Delta::apply(old.data(), old.size(), delta) == next);
+
+    DeltaStats s = Delta::stats(delta);
+    CHECK(s.insertedBytes < 64);
+    CHECK_EQ(s.copiedBytes + s.insertedBytes, next.size());
+}
@@ -0,0 +1,113 @@
+#include "test.h"
+#include "diff.h"
+
+static std::string numbered(int from, int to)
+{
+    std::string s;
+    for (int i = from; i < to; i++)
+        s += "line " + std::to_string(i) + " of a file that is long enough to compare\n";
+    return s;
+}
+
+TEST(diff_exact_rename)
+{
+    mygit({"init"});
+    writeFile("old.txt", numbered(0, 20));
+    writeFile("keep.txt", "keep\n");
+    std::string a = commitFiles({"old.txt", "keep.txt"}, "a");
+
+    writeFile("new.txt", numbered(0, 20));
+    std::string b = commitFiles({"new.txt", "keep.txt"}, "b");
+
+    auto pairs = Diff::renames(a, b);
+    CHECK_EQ(pairs.size(), 1u);
+    if (pairs.size() == 1)
+    {
+        CHECK_EQ(pairs[0].from, std::string("old.txt"));
+        CHECK_EQ(pairs[0].to, std::string("new.txt"));
+        CHECK_EQ(pairs[0].score, 100);
+        CHECK(!pairs[0].copy);
+    }
+}
+
+TEST(diff_edited_rename)
+{
+    mygit({"init"});
+    writeFile("old.txt", numbered(0, 20));
+    std::string a = commitFiles({"old.txt"}, "a");
+
+    writeFile("new.txt", numbered(0, 17) + "a changed tail\n");
+    std::string b = commitFiles({"new.txt"}, "b");
+
+    auto pairs = Diff::renames(a, b);
+    CHECK_EQ(pairs.size(), 1u);
+    if (pairs.size() == 1)
+    {
+        CHECK_EQ(pairs[0].to, std::string("new.txt"));
+        CHECK(pairs[0].score >= 50 && pairs[0].score < 100);
+    }
+}
+
+TEST(diff_unrelated_not_paired)
+{
+    mygit({"init"});
+    writeFile("old.txt", numbered(0, 20));
+    std::string a = commitFiles({"old.txt"}, "a");
+
+    writeFile("new.txt", numbered(1000, 1020));
+    std::string b = commitFiles({"new.txt"}, "b");
+
+    CHECK(Diff::renames(a, b).empty());
+}
+
+TEST(diff_rename_options)
+{
+    mygit({"init"});
+    writeFile("old.txt", numbered(0, 20));
+    writeFile("src.txt", numbered(100, 120));
+    std::string a = commitFiles({"old.txt", "src.txt"}, "a");
+
+    writeFile("new.txt", numbered(0, 20));
+    writeFile("copy.txt", numbered(100, 120));
+    std::string b = commitFiles({"new.txt", "src.txt", "copy.txt"}, "b");
+
+    DiffOptions off;
+    off.renames = false;
+    CHECK(Diff::renames(a, b, off).empty());
+
+    // Without copies, an added file matching an unchanged one stays an add.
+    auto plain = Diff::renames(a, b);
+    CHECK_EQ(plain.size(), 1u);
+
+    DiffOptions copies;
+    copies.copies = true;
+    auto pairs = Diff::renames(a, b, copies);
+    CHECK_EQ(pairs.size(), 2u);
+    bool sawCopy = false;
+    for (auto &p : pairs)
+    {
+        if (p.to == "copy.txt")
+        {
+            CHECK_EQ(p.from, std::string("src.txt"));
+            CHECK(p.copy);
+            sawCopy = true;
+        }
+    }
+    CHECK(sawCopy);
+}
+
+TEST(diff_unknown_commit)
+{
+    mygit({"init"});
+    writeFile("f.txt", "1\n");
+    std::string a = commitFiles({"f.txt"}, "a");
+
+    std::ostringstream out;
+    auto saved = std::cout.rdbuf(out.rdbuf());
+    int status = mygit({"diff", "--name-status", a, "no-such-commit"});
+    std::cout.rdbuf(saved);
+
+    CHECK_EQ(status, 1);
+    CHECK(out.str().find("Unknown commit 'no-such-commit'") != std::string::npos);
+    CHECK(out.str().find("Deleted") == std::string::npos);
+}
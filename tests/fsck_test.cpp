@@ -0,0 +1,31 @@
+#include "test.h"
+#include "fsck.h"
+
+TEST(fsck_reports_corrupt_meta)
+{
+    mygit({"init"});
+    writeFile("f.txt", "1\n");
+    commitFiles({"f.txt"}, "a");
+    writeFile("f.txt", "2\n");
+    std::string b = commitFiles({"f.txt"}, "b");
+
+    std::ostringstream out;
+    auto saved = std::cout.rdbuf(out.rdbuf());
+    int clean = Fsck::run(1);
+    std::cout.rdbuf(saved);
+    CHECK_EQ(clean, 0);
+
+    std::string path = ".mygit/objects/" + b + "/meta";
+    std::string meta = readFile(path);
+    auto at = meta.find("generation ");
+    meta.replace(at, meta.find('\n', at) - at, "generation x");
+    writeFile(path, meta);
+
+    out.str("");
+    saved = std::cout.rdbuf(out.rdbuf());
+    int status = Fsck::run(1);
+    std::cout.rdbuf(saved);
+
+    CHECK(status != 0);
+    CHECK(out.str().find("commit " + b + ": corrupt meta") != std::string::npos);
+}
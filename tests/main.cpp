@@ -0,0 +1,108 @@
+#include "test.h"
+#include "command.h"
+#include "objectcache.h"
+#include "repostate.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+std::vector<TestCase> &testRegistry()
+{
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+void testFailure(const char *file, int line, const std::string &message)
+{
+    std::cerr << "    " << file << ":" << line << ": " << message << "\n";
+    failures++;
+}
+
+int mygit(std::initializer_list<std::string> args)
+{
+    std::vector<std::string> argv{"mygit"};
+    argv.insert(argv.end(), args.begin(), args.end());
+    return Command::run(argv);
+}
+
+void writeFile(const std::string &path, const std::string &content)
+{
+    fs::path p(path);
+    if (!p.parent_path().empty())
+        fs::create_directories(p.parent_path());
+    std::ofstream(p, std::ios::binary) << content;
+}
+
+std::string readFile(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+std::string branchHead(const std::string &branch)
+{
+    return RepoState::firstLine(".mygit/branches/" + branch);
+}
+
+std::string commitFiles(const std::vector<std::string> &paths, const std::string &message)
+{
+    std::vector<std::string> argv{"mygit", "add"};
+    argv.insert(argv.end(), paths.begin(), paths.end());
+    Command::run(argv);
+    mygit({"commit", message});
+
+    std::string ref = RepoState::firstLine(".mygit/HEAD");
+    return branchHead(ref.substr(ref.find_last_of('/') + 1));
+}
+
+int main(int argc, char **argv)
+{
+    std::string filter = argc > 1 ? argv[1] : "";
+    fs::path origin = fs::current_path();
+    auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    fs::path root = fs::temp_directory_path() / ("mygit-tests-" + std::to_string(stamp));
+
+    int run = 0, failed = 0;
+
+    for (auto &t : testRegistry())
+    {
+        if (t.name.find(filter) == std::string::npos)
+            continue;
+
+        fs::path dir = root / t.name;
+        fs::create_directories(dir);
+        fs::current_path(dir);
+        ObjectCache::clear();
+
+        std::ostringstream swallowed;
+        auto saved = std::cout.rdbuf(swallowed.rdbuf());
+        int before = failures;
+
+        try
+        {
+            t.fn();
+        }
+        catch (const std::exception &e)
+        {
+            testFailure(__FILE__, __LINE__, std::string("exception: ") + e.what());
+        }
+
+        std::cout.rdbuf(saved);
+        fs::current_path(origin);
+
+        run++;
+        bool ok = failures == before;
+        failed += !ok;
+        std::cout << (ok ? "ok    " : "FAIL  ") << t.name << "\n";
+    }
+
+    fs::remove_all(root);
+    std::cout << run - failed << "/" << run << " tests passed\n";
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,236 @@
+#include "test.h"
+#include "merge.h"
+#include "objectcache.h"
+#include "repostate.h"
+#include <filesystem>
+
+TEST(merge_base_linear)
+{
+    mygit({"init"});
+    writeFile("f.txt", "1\n");
+    std::string a = commitFiles({"f.txt"}, "a");
+    writeFile("f.txt", "2\n");
+    std::string b = commitFiles({"f.txt"}, "b");
+    writeFile("f.txt", "3\n");
+    std::string c = commitFiles({"f.txt"}, "c");
+
+    CHECK(a != b && b != c);
+    CHECK_EQ(Merge::base(a, c), a);
+    CHECK_EQ(Merge::base(c, a), a);
+    CHECK_EQ(Merge::base(b, b), b);
+}
+
+TEST(merge_base_fork)
+{
+    mygit({"init"});
+    writeFile("f.txt", "base\n");
+    std::string fork = commitFiles({"f.txt"}, "base");
+    mygit({"branch", "dev"});
+
+    writeFile("f.txt", "ours\n");
+    std::string ours = commitFiles({"f.txt"}, "ours");
+    mygit({"checkout", "dev"});
+    writeFile("g.txt", "theirs\n");
+    std::string theirs = commitFiles({"f.txt", "g.txt"}, "theirs");
+
+    CHECK_EQ(Merge::base(ours, theirs), fork);
+    CHECK_EQ(Merge::base(theirs, ours), fork);
+    CHECK_EQ(Merge::base("NONE", ours), std::string("NONE"));
+}
+
+TEST(merge_base_after_merge)
+{
+    mygit({"init"});
+    writeFile("f.txt", "a\n");
+    commitFiles({"f.txt"}, "a");
+    mygit({"branch", "dev"});
+
+    writeFile("main.txt", "m\n");
+    commitFiles({"f.txt", "main.txt"}, "main work");
+    mygit({"checkout", "dev"});
+    writeFile("dev.txt", "1\n");
+    std::string b = commitFiles({"f.txt", "dev.txt"}, "dev work");
+
+    mygit({"checkout", "main"});
+    std::string main = branchHead("main");
+    mygit({"merge", "dev"});
+
+    // A clean merge commits by itself, with dev as the second parent.
+    std::string m = branchHead("main");
+    CHECK(m != main);
+    auto meta = ObjectCache::meta(m);
+    CHECK(meta && meta->parents.size() == 2);
+    if (meta && meta->parents.size() == 2)
+    {
+        CHECK_EQ(meta->parents[0], main);
+        CHECK_EQ(meta->parents[1], b);
+    }
+    CHECK(!std::filesystem::exists(".mygit/MERGE_HEAD"));
+
+    mygit({"checkout", "dev"});
+    writeFile("dev.txt", "2\n");
+    std::string d = commitFiles({"f.txt", "dev.txt"}, "more dev work");
+
+    // The merge made b reachable from main, so it is the best ancestor.
+    CHECK_EQ(Merge::base(m, d), b);
+}
+
+TEST(merge_three_way_lines)
+{
+    mygit({"init"});
+    writeFile("f.txt", "a\nb\nc\nd\ne\n");
+    writeFile("g.txt", "x\n");
+    commitFiles({"f.txt", "g.txt"}, "base");
+    mygit({"branch", "dev"});
+
+    writeFile("f.txt", "A\nb\nc\nd\ne\n");
+    commitFiles({"f.txt", "g.txt"}, "ours");
+    mygit({"checkout", "dev"});
+    writeFile("f.txt", "a\nb\nc\nd\nE\n");
+    writeFile("g.txt", "y\n");
+    writeFile("h.txt", "new\n");
+    commitFiles({"f.txt", "g.txt", "h.txt"}, "theirs");
+
+    mygit({"checkout", "main"});
+    mygit({"merge", "dev"});
+
+    CHECK_EQ(readFile("f.txt"), std::string("A\nb\nc\nd\nE\n"));
+    CHECK_EQ(readFile("g.txt"), std::string("y\n"));
+    CHECK_EQ(readFile("h.txt"), std::string("new\n"));
+}
+
+// Base with f.txt = a b c, main changes c, dev changes a.
+static void divergedBranches(const std::string &ours, const std::string &theirs)
+{
+    mygit({"init"});
+    writeFile("f.txt", "a\nb\nc\n");
+    commitFiles({"f.txt"}, "base");
+    mygit({"branch", "dev"});
+
+    writeFile("f.txt", ours);
+    commitFiles({"f.txt"}, "ours");
+    mygit({"checkout", "dev"});
+    writeFile("f.txt", theirs);
+    commitFiles({"f.txt"}, "theirs");
+    mygit({"checkout", "main"});
+}
+
+TEST(merge_refuses_local_changes)
+{
+    divergedBranches("a\nb\nC\n", "A\nb\nc\n");
+    std::string before = branchHead("main");
+
+    writeFile("f.txt", "a\nb\nC\nUNSAVED WORK\n");
+    mygit({"merge", "dev"});
+
+    CHECK_EQ(readFile("f.txt"), std::string("a\nb\nC\nUNSAVED WORK\n"));
+    CHECK_EQ(branchHead("main"), before);
+    CHECK(!std::filesystem::exists(".mygit/MERGE_HEAD"));
+
+    // An untracked file where theirs adds one is refused as well.
+    writeFile("f.txt", "a\nb\nC\n");
+    mygit({"checkout", "dev"});
+    writeFile("new.txt", "theirs\n");
+    commitFiles({"f.txt", "new.txt"}, "add new");
+    mygit({"checkout", "main"});
+    writeFile("new.txt", "mine\n");
+    mygit({"merge", "dev"});
+
+    CHECK_EQ(readFile("new.txt"), std::string("mine\n"));
+    CHECK_EQ(branchHead("main"), before);
+}
+
+TEST(checkout_refused_during_merge)
+{
+    divergedBranches("a\nb\nOURS\n", "a\nb\nTHEIRS\n");
+    mygit({"merge", "dev"});
+    CHECK(std::filesystem::exists(".mygit/MERGE_HEAD"));
+
+    std::string conflicted = readFile("f.txt");
+    mygit({"checkout", "dev"});
+
+    CHECK_EQ(RepoState::firstLine(".mygit/HEAD"), std::string("ref: refs/branches/main"));
+    CHECK_EQ(readFile("f.txt"), conflicted);
+}
+
+TEST(merge_fast_forward)
+{
+    mygit({"init"});
+    writeFile("f.txt", "1\n");
+    writeFile("gone.txt", "x\n");
+    std::string a = commitFiles({"f.txt", "gone.txt"}, "a");
+    mygit({"branch", "dev"});
+    mygit({"checkout", "dev"});
+    writeFile("f.txt", "2\n");
+    writeFile("added.txt", "y\n");
+    std::string b = commitFiles({"f.txt", "added.txt"}, "b");
+    mygit({"checkout", "main"});
+
+    CHECK_EQ(branchHead("main"), a);
+    mygit({"merge", "dev"});
+
+    // No merge commit: main simply moves to dev's commit.
+    CHECK_EQ(branchHead("main"), b);
+    CHECK_EQ(readFile("f.txt"), std::string("2\n"));
+    CHECK_EQ(readFile("added.txt"), std::string("y\n"));
+    CHECK(!std::filesystem::exists("gone.txt"));
+    CHECK(!std::filesystem::exists(".mygit/MERGE_HEAD"));
+}
+
+TEST(merge_conflict)
+{
+    divergedBranches("a\nb\nOURS\n", "a\nb\nTHEIRS\n");
+    std::string before = branchHead("main");
+    std::string dev = branchHead("dev");
+    mygit({"merge", "dev"});
+
+    // Nothing is committed; the conflicted file is staged with markers.
+    CHECK_EQ(branchHead("main"), before);
+    CHECK_EQ(RepoState::firstLine(".mygit/MERGE_HEAD"), dev);
+    CHECK_EQ(readFile("f.txt"),
+             std::string("a\nb\n<<<<<<< ours\nOURS\n=======\nTHEIRS\n>>>>>>> dev\n"));
+    CHECK_EQ(RepoState::firstLine(".mygit/index"), std::string("f.txt"));
+
+    writeFile("f.txt", "a\nb\nBOTH\n");
+    std::string m = commitFiles({"f.txt"}, "resolved");
+    auto meta = ObjectCache::meta(m);
+    CHECK(meta && meta->parents.size() == 2 && meta->parents[1] == dev);
+    CHECK(!std::filesystem::exists(".mygit/MERGE_HEAD"));
+}
+
+TEST(merge_respects_sparse_set)
+{
+    mygit({"init"});
+    writeFile("src/a.c", "1\n2\n3\n");
+    writeFile("src/b.c", "b\n");
+    writeFile("docs/d.md", "x\ny\nz\n");
+    commitFiles({"src/a.c", "src/b.c", "docs/d.md"}, "base");
+    mygit({"branch", "dev"});
+
+    writeFile("src/a.c", "1\n2\nOURS\n");
+    commitFiles({"src/a.c", "src/b.c", "docs/d.md"}, "ours");
+    mygit({"checkout", "dev"});
+    writeFile("src/a.c", "THEIRS\n2\n3\n");
+    writeFile("src/b.c", "b2\n");
+    writeFile("docs/d.md", "x\nY\nz\n");
+    commitFiles({"src/a.c", "src/b.c", "docs/d.md"}, "theirs");
+    mygit({"checkout", "main"});
+    mygit({"sparse-checkout", "set", "docs"});
+    CHECK(!std::filesystem::exists("src"));
+
+    std::string before = branchHead("main");
+    mygit({"merge", "dev"});
+
+    // Nothing outside the set is written, yet the commit holds every result.
+    std::string m = branchHead("main");
+    CHECK(m != before);
+    CHECK(!std::filesystem::exists("src"));
+    CHECK_EQ(readFile("docs/d.md"), std::string("x\nY\nz\n"));
+
+    std::string files = ".mygit/objects/" + m + "/files/";
+    CHECK_EQ(readFile(files + "src/a.c"), std::string("THEIRS\n2\nOURS\n"));
+    CHECK_EQ(readFile(files + "src/b.c"), std::string("b2\n"));
+    CHECK(!std::filesystem::exists(".mygit/MERGE_HEAD"));
+    CHECK(!std::filesystem::exists(".mygit/MERGE_SOURCES"));
+    CHECK(!std::filesystem::exists(".mygit/merge-results"));
+}
@@ -0,0 +1,31 @@
+#include "test.h"
+#include "commit.h"
+#include "objectcache.h"
+
+TEST(meta_with_bad_generation)
+{
+    mygit({"init"});
+    writeFile("f.txt", "1\n");
+    std::string a = commitFiles({"f.txt"}, "a");
+    writeFile("f.txt", "2\n");
+    std::string b = commitFiles({"f.txt"}, "b");
+
+    std::string path = ".mygit/objects/" + b + "/meta";
+    std::string meta = readFile(path);
+    auto at = meta.find("generation ");
+    CHECK(at != std::string::npos);
+    meta.replace(at, meta.find('\n', at) - at, "generation x");
+    writeFile(path, meta);
+    ObjectCache::clear();
+
+    // Unknown generation: recomputed from the parents.
+    auto m = ObjectCache::meta(b);
+    CHECK(m != nullptr);
+    if (m)
+    {
+        CHECK_EQ(m->generation, 0ul);
+        CHECK_EQ(m->parents.size(), 1u);
+    }
+    CHECK_EQ(Commit::generation(b), 2ul);
+    CHECK_EQ(mygit({"log"}), 0);
+}
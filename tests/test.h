@@ -0,0 +1,78 @@
+/*
+Minimal test harness (no external framework).
+    TEST(name) { CHECK(cond); CHECK_EQ(actual, expected); }
+Every test runs in its own empty temporary directory, which is the
+current directory while it runs, so tests that build a repository
+through Command::run never touch the source tree. Command output is
+swallowed; failures go to stderr.
+Build: see "Running Tests" in readme.MD.
+    ./mygit-tests [name-filter]   runs tests whose name contains the filter
+*/
+#ifndef TEST_H
+#define TEST_H
+
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct TestCase
+{
+    std::string name;
+    std::function<void()> fn;
+};
+
+std::vector<TestCase> &testRegistry();
+void testFailure(const char *file, int line, const std::string &message);
+
+struct TestRegistrar
+{
+    TestRegistrar(const std::string &name, std::function<void()> fn)
+    {
+        testRegistry().push_back({name, fn});
+    }
+};
+
+#define TEST(name)                                              \
+    static void test_##name();                                  \
+    static TestRegistrar registrar_##name(#name, test_##name);  \
+    static void test_##name()
+
+#define CHECK(cond)                                             \
+    do                                                          \
+    {                                                           \
+        if (!(cond))                                            \
+            testFailure(__FILE__, __LINE__, "CHECK(" #cond ")"); \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                 \
+    do                                                                             \
+    {                                                                              \
+        auto a_ = (actual);                                                        \
+        auto e_ = (expected);                                                      \
+        if (!(a_ == e_))                                                           \
+        {                                                                          \
+            std::ostringstream m_;                                                 \
+            m_ << #actual << " == " << #expected << " (got " << a_ << ", expected " \
+               << e_ << ")";                                                       \
+            testFailure(__FILE__, __LINE__, m_.str());                             \
+        }                                                                          \
+    } while (0)
+
+// ---- repository helpers ----
+
+// Runs "mygit <args...>" through the command dispatcher.
+int mygit(std::initializer_list<std::string> args);
+
+void writeFile(const std::string &path, const std::string &content);
+std::string readFile(const std::string &path);
+
+// Commit a branch currently points to.
+std::string branchHead(const std::string &branch);
+
+// Stages the given files and commits them; returns the new commit.
+std::string commitFiles(const std::vector<std::string> &paths, const std::string &message);
+
+#endif
@@ -0,0 +1,25 @@
+#include "test.h"
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+TEST(worktree_in_shared_clone)
+{
+    fs::path top = fs::current_path();
+    fs::create_directory("origin");
+    fs::current_path("origin");
+    mygit({"init"});
+    writeFile("f.txt", "1\n");
+    writeFile("sub/g.txt", "2\n");
+    commitFiles({"f.txt", "sub/g.txt"}, "a");
+    mygit({"branch", "dev"});
+
+    fs::current_path(top);
+    mygit({"clone", "--shared", "origin", "copy"});
+    fs::current_path("copy");
+
+    // The clone's objects live in origin, found through alternates.
+    mygit({"worktree", "add", "../wt", "dev"});
+    CHECK_EQ(readFile("../wt/f.txt"), std::string("1\n"));
+    CHECK_EQ(readFile("../wt/sub/g.txt"), std::string("2\n"));
+}